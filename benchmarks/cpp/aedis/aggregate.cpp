@@ -0,0 +1,83 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+// Parses large aggregates, like the replies to SMEMBERS on a big set
+// or HGETALL on a wide hash, that are already in the read buffer and
+// prints the cost per element.
+
+#include <map>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+
+#include <aedis.hpp>
+#include <aedis/resp3/read.hpp>
+#include <aedis/src.hpp>
+
+namespace resp3 = aedis::resp3;
+using aedis::adapter::adapt2;
+
+int constexpr repeat = 10;
+
+template <class Adapter>
+auto parse(std::string const& payload, Adapter adapter)
+{
+   resp3::detail::parser<Adapter> p{adapter};
+   boost::system::error_code ec;
+
+   auto const start = std::chrono::steady_clock::now();
+   auto const n = resp3::detail::consume_available(p, payload.data(), payload.size(), ec);
+   auto const dt = std::chrono::steady_clock::now() - start;
+
+   if (ec || n != payload.size() || !p.done())
+      std::printf("Error: %s\n", ec.message().c_str());
+
+   return dt;
+}
+
+template <class Response>
+void run(char const* name, std::string const& payload, std::size_t elements)
+{
+   std::chrono::steady_clock::duration dt{};
+   for (int i = 0; i < repeat; ++i) {
+      Response resp;
+      dt += parse(payload, adapt2(resp));
+   }
+
+   auto const ns = std::chrono::duration<double, std::nano>(dt).count() / (repeat * static_cast<double>(elements));
+   std::printf("%-30s %8.2f ns/element\n", name, ns);
+}
+
+int main()
+{
+   std::size_t constexpr size = 1000000;
+
+   std::string set = "~" + std::to_string(size) + "\r\n";
+   for (std::size_t i = 0; i < size; ++i) {
+      auto const e = "member:" + std::to_string(i);
+      set += "$" + std::to_string(e.size()) + "\r\n" + e + "\r\n";
+   }
+
+   std::string hash = "%" + std::to_string(size / 2) + "\r\n";
+   for (std::size_t i = 0; i < size / 2; ++i) {
+      auto const k = "field:" + std::to_string(i);
+      hash += "$" + std::to_string(k.size()) + "\r\n" + k + "\r\n";
+      hash += ":" + std::to_string(i) + "\r\n";
+   }
+
+   run<std::vector<std::string>>("set (vector<string>)", set, size);
+   run<resp3::response_view>("set (response_view)", set, size);
+   run<std::map<std::string, long long>>("hash (map<string, int64>)", hash, size);
+   run<std::vector<resp3::node<std::string>>>("hash (vector<node>)", hash, size);
+
+   std::chrono::steady_clock::duration dt{};
+   for (int i = 0; i < repeat; ++i)
+      dt += parse(set, adapt2());
+
+   std::printf("%-30s %8.2f ns/element\n", "set (ignored)",
+      std::chrono::duration<double, std::nano>(dt).count() / (repeat * static_cast<double>(size)));
+}
@@ -0,0 +1,143 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+// Measures the time the connection spends per async_exec. The server
+// runs in a thread on a loopback connection and answers each PING
+// with +PONG without parsing it. Sessions execute their requests one
+// after the other, concurrently with each other. Besides the wall
+// time the CPU time of the client thread is printed, which is not
+// affected by the scheduling of the server thread.
+
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <ctime>
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/io_context.hpp>
+
+#include <aedis.hpp>
+#include <aedis/src.hpp>
+
+#if !defined(_WIN32)
+
+namespace net = boost::asio;
+namespace resp3 = aedis::resp3;
+using aedis::adapt;
+using connection = aedis::connection;
+using tcp = net::ip::tcp;
+
+int constexpr requests = 200000;
+std::size_t const sessions[] = {1, 10, 100};
+
+auto thread_cpu_time() -> double
+{
+   timespec ts{};
+   ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+   return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+void serve(tcp::socket socket)
+{
+   std::string const request = "*1\r\n$4\r\nPING\r\n";
+   std::string const response = "+PONG\r\n";
+
+   std::string buffer(64 * 1024, '\0');
+   std::string responses;
+   std::size_t pending = 0;
+   boost::system::error_code ec;
+   for (;;) {
+      auto const n = socket.read_some(net::buffer(buffer), ec);
+      if (ec)
+         return;
+
+      pending += n;
+      responses.clear();
+      for (; pending >= request.size(); pending -= request.size())
+         responses += response;
+
+      net::write(socket, net::buffer(responses), ec);
+      if (ec)
+         return;
+   }
+}
+
+struct benchmark {
+   connection* conn = nullptr;
+   resp3::request req;
+   std::vector<std::tuple<std::string>> resps;
+   std::size_t round = 0;
+   std::size_t remaining = 0;
+   std::chrono::steady_clock::time_point start;
+   double cpu_start = 0;
+
+   void start_round()
+   {
+      if (round == std::size(sessions)) {
+         conn->cancel(aedis::operation::run);
+         return;
+      }
+
+      resps.resize(sessions[round]);
+      remaining = sessions[round];
+      start = std::chrono::steady_clock::now();
+      cpu_start = thread_cpu_time();
+      for (auto& resp : resps)
+         exec(resp, requests / sessions[round]);
+   }
+
+   void exec(std::tuple<std::string>& resp, int n)
+   {
+      if (n == 0) {
+         if (--remaining == 0) {
+            auto const dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            auto const cpu = thread_cpu_time() - cpu_start;
+            std::printf(
+               "Sessions: %4zu %8.0f ns/request %8.0f ns CPU/request\n",
+               sessions[round], dt * 1e9 / requests, cpu * 1e9 / requests);
+            ++round;
+            start_round();
+         }
+         return;
+      }
+
+      conn->async_exec(req, adapt(resp), [this, &resp, n](auto ec, auto) {
+         if (ec) {
+            std::printf("Error: %s\n", ec.message().c_str());
+            return;
+         }
+
+         exec(resp, n - 1);
+      });
+   }
+};
+
+int main()
+{
+   net::io_context ioc;
+   tcp::acceptor acc{ioc, {net::ip::address_v4::loopback(), 0}};
+
+   connection conn{ioc};
+   conn.next_layer().connect(acc.local_endpoint());
+   std::thread server{serve, acc.accept()};
+
+   benchmark b;
+   b.conn = &conn;
+   b.req.push("PING");
+   b.start_round();
+
+   conn.async_run([](auto) { });
+   ioc.run();
+
+   conn.next_layer().close();
+   server.join();
+}
+
+#else
+int main() {}
+#endif
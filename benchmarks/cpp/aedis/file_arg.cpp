@@ -0,0 +1,96 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+// Writes SET requests whose value is the content of a file to a
+// loopback TCP connection, once reading the file into the request
+// and once passing it as a resp3::file_arg, and prints the
+// throughput of each. The other end of the connection only discards
+// the data.
+
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/io_context.hpp>
+
+#include <aedis.hpp>
+#include <aedis/src.hpp>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+
+namespace net = boost::asio;
+namespace resp3 = aedis::resp3;
+using tcp = net::ip::tcp;
+
+int constexpr repeat = 100;
+
+template <class F>
+void run(char const* name, tcp::socket& socket, std::size_t size, F make_request)
+{
+   auto const start = std::chrono::steady_clock::now();
+   for (int i = 0; i < repeat; ++i)
+      resp3::write(socket, make_request());
+
+   auto const dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   std::printf("%-20s %8.1f MB/s\n", name, repeat * static_cast<double>(size) / dt / 1e6);
+}
+
+int main()
+{
+   std::size_t const sizes[] = {100 * 1024, 1024 * 1024, 10 * 1024 * 1024};
+
+   net::io_context ioc;
+   tcp::acceptor acc{ioc, {net::ip::address_v4::loopback(), 0}};
+   tcp::socket socket{ioc};
+   socket.connect(acc.local_endpoint());
+   auto peer = acc.accept();
+
+   std::thread drain{[&]() {
+      std::string buffer(1024 * 1024, '\0');
+      boost::system::error_code ec;
+      while (!ec)
+         peer.read_some(net::buffer(buffer), ec);
+   }};
+
+   for (auto size : sizes) {
+      std::printf("Value size: %zu\n", size);
+
+      auto* file = std::tmpfile();
+      std::string const content(size, 'a');
+      std::fwrite(content.data(), 1, content.size(), file);
+      std::fflush(file);
+      auto const fd = fileno(file);
+
+      std::string value;
+      run("copy", socket, size, [&]() {
+         value.resize(size);
+         if (::pread(fd, value.data(), size, 0) != static_cast<ssize_t>(size))
+            std::printf("Error: pread\n");
+
+         resp3::request req;
+         req.push("SET", "key", value);
+         return req;
+      });
+
+      run("file_arg", socket, size, [&]() {
+         resp3::request req;
+         req.push("SET", "key", resp3::file_arg{fd, 0, size});
+         return req;
+      });
+
+      std::fclose(file);
+   }
+
+   socket.shutdown(tcp::socket::shutdown_send);
+   drain.join();
+}
+
+#else
+int main() {}
+#endif
@@ -0,0 +1,100 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+// Compares the numeric decoders used by the RESP3 parser with the
+// Boost.Spirit X3 parsers they replaced.
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include <boost/spirit/home/x3.hpp>
+
+#include <aedis.hpp>
+#include <aedis/src.hpp>
+
+namespace resp3 = aedis::resp3;
+
+auto spirit_uint(char const* data, std::size_t size, boost::system::error_code& ec) -> std::size_t
+{
+   static constexpr boost::spirit::x3::uint_parser<std::size_t, 10> p{};
+   std::size_t ret = 0;
+   if (!parse(data, data + size, p, ret))
+      ec = aedis::error::not_a_number;
+
+   return ret;
+}
+
+auto spirit_int(char const* data, std::size_t size, boost::system::error_code& ec) -> std::int64_t
+{
+   static constexpr boost::spirit::x3::int_parser<std::int64_t, 10> p{};
+   std::int64_t ret = 0;
+   if (!parse(data, data + size, p, ret))
+      ec = aedis::error::not_a_number;
+
+   return ret;
+}
+
+auto spirit_double(char const* data, std::size_t size, boost::system::error_code& ec) -> double
+{
+   static constexpr boost::spirit::x3::real_parser<double> p{};
+   double ret = 0;
+   if (!parse(data, data + size, p, ret))
+      ec = aedis::error::not_a_double;
+
+   return ret;
+}
+
+template <class F>
+auto run(char const* name, std::vector<std::string> const& input, F f)
+{
+   int constexpr repeat = 1000;
+   double sum = 0;
+   boost::system::error_code ec;
+
+   auto const start = std::chrono::steady_clock::now();
+   for (int i = 0; i < repeat; ++i) {
+      for (auto const& e: input)
+         sum += static_cast<double>(f(e.data(), e.size(), ec));
+   }
+   auto const dt = std::chrono::steady_clock::now() - start;
+
+   auto const ns = std::chrono::duration<double, std::nano>(dt).count() / (repeat * static_cast<double>(input.size()));
+   std::printf("%-22s %8.2f ns/op %s (checksum %g)\n", name, ns, ec ? "error" : "", sum);
+}
+
+int main()
+{
+   // Small enough to stay in the cache.
+   std::size_t constexpr size = 10000;
+   std::mt19937_64 rng{0};
+
+   // Bulk lengths and aggregate sizes are mostly short.
+   std::vector<std::string> lengths;
+   for (std::size_t i = 0; i < size; ++i)
+      lengths.push_back(std::to_string(rng() % 100000));
+
+   std::vector<std::string> ints;
+   for (std::size_t i = 0; i < size; ++i)
+      ints.push_back(std::to_string(static_cast<std::int64_t>(rng()) >> (rng() % 64)));
+
+   std::vector<std::string> doubles;
+   for (std::size_t i = 0; i < size; ++i) {
+      char buf[64];
+      auto const d = static_cast<double>(static_cast<std::int64_t>(rng() % 2000000) - 1000000) / 1024;
+      auto const n = std::snprintf(buf, sizeof buf, i % 2 ? "%.17g" : "%g", d);
+      doubles.emplace_back(buf, n);
+   }
+
+   run("uint (spirit)", lengths, spirit_uint);
+   run("uint (aedis)", lengths, resp3::detail::parse_uint);
+   run("int64 (spirit)", ints, spirit_int);
+   run("int64 (aedis)", ints, resp3::detail::parse_int);
+   run("double (spirit)", doubles, spirit_double);
+   run("double (aedis)", doubles, resp3::detail::parse_double);
+}
@@ -0,0 +1,99 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+// Parses a pipeline of replies that is already in the read buffer,
+// e.g. after a large read, one response at a time the way the
+// connection does, and prints the cost per byte as the number of
+// replies grows. With a std::string every consumed response shifts
+// the remaining bytes so the cost per byte grows linearly,
+// resp3::read_buffer only moves a cursor and the cost stays flat.
+
+#include <string>
+#include <chrono>
+#include <cstdio>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/error.hpp>
+
+#include <aedis.hpp>
+#include <aedis/resp3/read.hpp>
+#include <aedis/src.hpp>
+
+namespace net = boost::asio;
+namespace resp3 = aedis::resp3;
+using aedis::adapter::adapt2;
+
+// A stream that reads from memory.
+class memory_stream {
+public:
+   explicit memory_stream(std::string const& data) : data_{data} {}
+
+   template <class MutableBufferSequence>
+   auto read_some(MutableBufferSequence const& buffers, boost::system::error_code& ec) -> std::size_t
+   {
+      if (pos_ == data_.size()) {
+         ec = net::error::eof;
+         return 0;
+      }
+
+      auto const n = net::buffer_copy(buffers, net::buffer(data_.data() + pos_, data_.size() - pos_));
+      pos_ += n;
+      return n;
+   }
+
+   template <class MutableBufferSequence>
+   auto read_some(MutableBufferSequence const& buffers) -> std::size_t
+   {
+      boost::system::error_code ec;
+      auto const n = read_some(buffers, ec);
+      if (ec)
+         throw boost::system::system_error{ec};
+      return n;
+   }
+
+private:
+   std::string const& data_;
+   std::size_t pos_ = 0;
+};
+
+template <class DynamicBuffer>
+auto read_all(std::string const& payload, std::size_t replies, DynamicBuffer buf)
+{
+   // Everything is in the buffer, the stream is at EOF.
+   std::string const empty;
+   memory_stream stream{empty};
+   buf.grow(payload.size());
+   net::buffer_copy(buf.data(0, payload.size()), net::buffer(payload));
+
+   std::string value;
+   auto const start = std::chrono::steady_clock::now();
+   for (std::size_t i = 0; i < replies; ++i) {
+      resp3::read(stream, buf, adapt2(value));
+      value.clear();
+   }
+
+   auto const dt = std::chrono::steady_clock::now() - start;
+   return std::chrono::duration<double, std::nano>(dt).count() / static_cast<double>(payload.size());
+}
+
+int main()
+{
+   std::printf("%10s %12s %18s %18s\n", "replies", "bytes", "string ns/byte", "read_buffer ns/byte");
+
+   for (std::size_t replies = 1000; replies <= 64000; replies *= 4) {
+      std::string payload;
+      for (std::size_t i = 0; i < replies; ++i)
+         payload += "$11\r\nhello world\r\n";
+
+      std::string sbuf;
+      auto const t1 = read_all(payload, replies, net::dynamic_buffer(sbuf));
+
+      resp3::read_buffer rbuf;
+      auto const t2 = read_all(payload, replies, resp3::dynamic_buffer(rbuf));
+
+      std::printf("%10zu %12zu %18.3f %18.3f\n", replies, payload.size(), t1, t2);
+   }
+}
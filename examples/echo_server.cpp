@@ -24,19 +24,22 @@ using signal_set_type = net::use_awaitable_t<>::as_default_on_t<net::signal_set>
 
 using aedis::adapt;
 using aedis::resp3::request;
+using aedis::resp3::prepared_request;
 
 auto echo_server_session(tcp_socket socket, std::shared_ptr<connection> conn) -> net::awaitable<void>
 {
-   request req;
+   // The command is serialized once, only its argument is rebound
+   // on each message.
+   prepared_request req;
+   req.push("PING", "");
    std::tuple<std::string> response;
 
    for (std::string buffer;;) {
       auto n = co_await net::async_read_until(socket, net::dynamic_buffer(buffer, 1024), "\n");
-      req.push("PING", buffer);
+      req.bind(0, buffer);
       co_await conn->async_exec(req, adapt(response));
       co_await net::async_write(socket, net::buffer(std::get<0>(response)));
       std::get<0>(response).clear();
-      req.clear();
       buffer.erase(0, n);
    }
 }
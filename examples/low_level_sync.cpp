@@ -36,13 +36,14 @@ int main()
       resp3::write(socket, req);
 
       // Responses
-      std::string buffer, resp;
-
-      // Reads the responses to all commands in the request.
-      auto dbuffer = net::dynamic_buffer(buffer);
-      resp3::read(socket, dbuffer);
-      resp3::read(socket, dbuffer, adapt2(resp));
-      resp3::read(socket, dbuffer);
+      std::string resp;
+
+      // Reads the responses to all commands in the request, usually
+      // with a single read from the socket.
+      resp3::reader<tcp::socket> reader{socket};
+      reader.read();
+      reader.read(adapt2(resp));
+      reader.read();
 
       std::cout << "Ping: " << resp << std::endl;
 
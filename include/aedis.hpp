@@ -9,8 +9,11 @@
 
 #include <aedis/error.hpp>
 #include <aedis/adapt.hpp>
+#include <aedis/command.hpp>
 #include <aedis/connection.hpp>
 #include <aedis/resp3/request.hpp>
+#include <aedis/resp3/prepared_request.hpp>
+#include <aedis/resp3/reader.hpp>
 
 /** @defgroup high-level-api Reference
  *
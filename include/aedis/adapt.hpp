@@ -8,7 +8,10 @@
 #define AEDIS_ADAPT_HPP
 
 #include <tuple>
+#include <array>
 #include <limits>
+#include <utility>
+#include <type_traits>
 
 #include <boost/mp11.hpp>
 #include <boost/variant2.hpp>
@@ -16,6 +19,8 @@
 #include <boost/system.hpp>
 
 #include <aedis/resp3/node.hpp>
+#include <aedis/resp3/response_view.hpp>
+#include <aedis/resp3/detail/parser.hpp>
 #include <aedis/adapter/adapt.hpp>
 #include <aedis/adapter/detail/response_traits.hpp>
 
@@ -35,9 +40,82 @@ namespace aedis {
  */
 using ignore = adapter::detail::ignore;
 
+/** @brief Response type that passes the values it receives to a callback.
+ *  @ingroup high-level-api
+ *
+ *  Bulk strings are delivered in chunks as they are read from the
+ *  socket so that memory usage doesn't depend on their size, which
+ *  makes this type suitable for large values that are e.g. hashed,
+ *  written to a file or forwarded to another socket. The callback
+ *  must have the signature
+ *
+ *  @code
+ *  void f(boost::string_view chunk, bool last, boost::system::error_code& ec);
+ *  @endcode
+ *
+ *  where last is true on the final chunk of a value. Values that are
+ *  not bulk strings, the elements of aggregates and small bulk
+ *  strings arrive in a single chunk. Setting ec aborts the
+ *  operation. Use aedis::make_sink to create objects of this type,
+ *  for example
+ *
+ *  @code
+ *  auto s = make_sink([&](auto chunk, bool last, auto&) { ... });
+ *  std::tuple<aedis::ignore, decltype(s)> resp{{}, s};
+ *  co_await conn->async_exec(req, adapt(resp));
+ *  @endcode
+ */
+template <class Callback>
+using sink = adapter::detail::sink<Callback>;
+
+/** @brief Creates a sink response.
+ *  @ingroup high-level-api
+ *
+ *  @param callback The callback, see aedis::sink.
+ */
+template <class Callback>
+auto make_sink(Callback callback)
+{
+   return sink<Callback>{std::move(callback)};
+}
+
 namespace detail
 {
 
+/* Adapters passed to the connection report the responses they don't
+ * need with
+ *
+ *    resp3::detail::skip_mode get_skip_mode(std::size_t i) const noexcept;
+ *
+ * where i is the index of the response in the request.
+ */
+template <class Adapter, class = void>
+struct has_indexed_skip_mode : std::false_type {};
+
+template <class Adapter>
+struct has_indexed_skip_mode<Adapter, std::void_t<
+   decltype(std::declval<Adapter const&>().get_skip_mode(std::size_t{}))
+   >> : std::true_type {};
+
+template <class Adapter>
+auto get_skip_mode(Adapter const& adapter, std::size_t i) noexcept -> resp3::detail::skip_mode
+{
+   if constexpr (has_indexed_skip_mode<Adapter>::value)
+      return adapter.get_skip_mode(i);
+   else
+      return resp3::detail::skip_mode::none;
+}
+
+// Indices of the elements of a tuple that are ignored.
+template <class>
+struct ignored_indices;
+
+template <class... Ts>
+struct ignored_indices<std::tuple<Ts...>> {
+   static constexpr std::array<bool, sizeof...(Ts)> value
+      {{std::is_same<std::decay_t<Ts>, adapter::detail::ignore>::value...}};
+};
+
 class ignore_adapter {
 public:
    explicit ignore_adapter(std::size_t max_read_size) : max_read_size_{max_read_size} {}
@@ -54,6 +132,10 @@ public:
    auto get_max_read_size(std::size_t) const noexcept
       { return max_read_size_;}
 
+   [[nodiscard]]
+   auto get_skip_mode(std::size_t) const noexcept
+      { return resp3::detail::skip_mode::discard;}
+
 private:
    std::size_t max_read_size_;
 };
@@ -84,6 +166,14 @@ public:
    auto get_max_read_size(std::size_t) const noexcept
       { return max_read_size_;}
 
+   [[nodiscard]]
+   auto get_skip_mode(std::size_t i) const noexcept
+   {
+      return i < size && ignored_indices<Tuple>::value[i]
+         ? resp3::detail::skip_mode::check_errors
+         : resp3::detail::skip_mode::none;
+   }
+
    void
    operator()(
       std::size_t i,
@@ -95,6 +185,67 @@ public:
       BOOST_ASSERT(i < adapters_.size());
       visit([&](auto& arg){arg(nd, ec);}, adapters_.at(i));
    }
+
+   template <
+      class Value,
+      bool B = adapter::detail::any_accepts_typed_scalars<Tuple>::value,
+      class = std::enable_if_t<B>>
+   void
+   operator()(
+      std::size_t i,
+      resp3::node<boost::string_view> const& nd,
+      Value v,
+      boost::system::error_code& ec)
+   {
+      using boost::variant2::visit;
+      BOOST_ASSERT(i < adapters_.size());
+      visit([&](auto& arg){resp3::detail::call_adapter(arg, nd, v, ec);}, adapters_.at(i));
+   }
+
+   template <
+      bool B = adapter::detail::any_has_bulk_storage<Tuple>::value,
+      class = std::enable_if_t<B>>
+   auto
+   get_bulk_storage(
+      std::size_t i,
+      resp3::node<boost::string_view> const& nd,
+      std::size_t size,
+      boost::system::error_code& ec) -> char*
+   {
+      using boost::variant2::visit;
+      BOOST_ASSERT(i < adapters_.size());
+      return visit([&](auto& arg){return adapter::detail::get_bulk_storage(arg, nd, size, ec);}, adapters_.at(i));
+   }
+
+   template <
+      bool B = adapter::detail::any_has_bulk_sink<Tuple>::value,
+      class = std::enable_if_t<B>>
+   auto
+   begin_bulk_chunks(
+      std::size_t i,
+      resp3::node<boost::string_view> const& nd,
+      std::size_t size,
+      boost::system::error_code& ec) -> bool
+   {
+      using boost::variant2::visit;
+      BOOST_ASSERT(i < adapters_.size());
+      return visit([&](auto& arg){return adapter::detail::begin_bulk_chunks(arg, nd, size, ec);}, adapters_.at(i));
+   }
+
+   template <
+      bool B = adapter::detail::any_has_bulk_sink<Tuple>::value,
+      class = std::enable_if_t<B>>
+   void
+   on_bulk_chunk(
+      std::size_t i,
+      resp3::node<boost::string_view> const& nd,
+      std::size_t remaining,
+      boost::system::error_code& ec)
+   {
+      using boost::variant2::visit;
+      BOOST_ASSERT(i < adapters_.size());
+      visit([&](auto& arg){adapter::detail::on_bulk_chunk(arg, nd, remaining, ec);}, adapters_.at(i));
+   }
 };
 
 template <class Vector>
@@ -127,6 +278,19 @@ public:
    {
       adapter_(nd, ec);
    }
+
+   template <
+      class A = adapter_type,
+      class = std::enable_if_t<resp3::detail::has_bulk_storage<A>::value>>
+   auto
+   get_bulk_storage(
+      std::size_t,
+      resp3::node<boost::string_view> const& nd,
+      std::size_t size,
+      boost::system::error_code& ec) -> char*
+   {
+      return adapter_.get_bulk_storage(nd, size, ec);
+   }
 };
 
 template <class>
@@ -150,6 +314,15 @@ struct response_traits<std::vector<resp3::node<String>, Allocator>> {
       { return adapter_type{v, max_read_size}; }
 };
 
+template <>
+struct response_traits<resp3::response_view> {
+   using response_type = resp3::response_view;
+   using adapter_type = vector_adapter<response_type>;
+
+   static auto adapt(response_type& v, std::size_t max_read_size) noexcept
+      { return adapter_type{v, max_read_size}; }
+};
+
 template <class ...Ts>
 struct response_traits<std::tuple<Ts...>> {
    using response_type = std::tuple<Ts...>;
@@ -167,6 +340,13 @@ public:
    void operator()(resp3::node<boost::string_view> const& node, boost::system::error_code& ec)
       { return adapter_(0, node, ec); }
 
+   template <
+      class Value,
+      class A = Adapter,
+      class = decltype(std::declval<A&>()(std::size_t{}, std::declval<resp3::node<boost::string_view> const&>(), std::declval<Value>(), std::declval<boost::system::error_code&>()))>
+   void operator()(resp3::node<boost::string_view> const& node, Value v, boost::system::error_code& ec)
+      { return adapter_(0, node, v, ec); }
+
    [[nodiscard]]
    auto get_supported_response_size() const noexcept
       { return adapter_.get_supported_response_size();}
@@ -175,6 +355,25 @@ public:
    auto get_max_read_size(std::size_t) const noexcept
       { return adapter_.get_max_read_size(0); }
 
+   [[nodiscard]]
+   auto get_skip_mode() const noexcept
+      { return detail::get_skip_mode(adapter_, 0); }
+
+   template <
+      class A = Adapter,
+      class = decltype(std::declval<A&>().get_bulk_storage(std::size_t{}, std::declval<resp3::node<boost::string_view> const&>(), std::size_t{}, std::declval<boost::system::error_code&>()))>
+   auto get_bulk_storage(resp3::node<boost::string_view> const& nd, std::size_t size, boost::system::error_code& ec) -> char*
+      { return adapter_.get_bulk_storage(0, nd, size, ec); }
+
+   template <
+      class A = Adapter,
+      class = decltype(std::declval<A&>().begin_bulk_chunks(std::size_t{}, std::declval<resp3::node<boost::string_view> const&>(), std::size_t{}, std::declval<boost::system::error_code&>()))>
+   auto begin_bulk_chunks(resp3::node<boost::string_view> const& nd, std::size_t size, boost::system::error_code& ec) -> bool
+      { return adapter_.begin_bulk_chunks(0, nd, size, ec); }
+
+   void on_bulk_chunk(resp3::node<boost::string_view> const& nd, std::size_t remaining, boost::system::error_code& ec)
+      { adapter_.on_bulk_chunk(0, nd, remaining, ec); }
+
 private:
    Adapter adapter_;
 };
@@ -204,10 +403,11 @@ inline auto adapt(std::size_t max_read_size = (std::numeric_limits<std::size_t>:
 /** @brief Adapts a type to be used as a response.
  *  @ingroup high-level-api
  *
- *  The type T must be either
+ *  The type T must be one of
  *
- *  1. a std::tuple<T1, T2, T3, ...> or
- *  2. std::vector<node<String>>
+ *  1. a std::tuple<T1, T2, T3, ...>,
+ *  2. std::vector<node<String>> or
+ *  3. resp3::response_view
  *
  *  The types T1, T2, etc can be any STL container, any integer type
  *  and \c std::string
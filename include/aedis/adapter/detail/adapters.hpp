@@ -18,10 +18,11 @@
 #include <deque>
 #include <vector>
 #include <array>
+#include <limits>
+#include <cstdint>
+#include <type_traits>
 
 #include <boost/assert.hpp>
-#include <boost/spirit/include/qi.hpp>
-#include <boost/spirit/home/x3.hpp>
 #include <boost/utility/string_view.hpp>
 
 #include <aedis/error.hpp>
@@ -29,23 +30,10 @@
 #include <aedis/resp3/request.hpp>
 #include <aedis/resp3/detail/parser.hpp>
 #include <aedis/resp3/node.hpp>
+#include <aedis/resp3/response_view.hpp>
 
 namespace aedis::adapter::detail {
 
-inline
-auto parse_double(
-   char const* data,
-   std::size_t size,
-   boost::system::error_code& ec) -> double
-{
-   static constexpr boost::spirit::x3::real_parser<double> p{};
-   double ret = 0;
-   if (!parse(data, data + size, p, ret))
-      ec = error::not_a_double;
-
-   return ret;
-}
-
 // Serialization.
 
 template <class T>
@@ -54,7 +42,29 @@ auto from_bulk(
    boost::string_view sv,
    boost::system::error_code& ec) -> typename std::enable_if<std::is_integral<T>::value, void>::type
 {
-   i = resp3::detail::parse_uint(sv.data(), sv.size(), ec);
+   if constexpr (std::is_signed<T>::value) {
+      auto const v = resp3::detail::parse_int(sv.data(), sv.size(), ec);
+      if (ec)
+         return;
+
+      if (v < (std::numeric_limits<T>::min)() || v > (std::numeric_limits<T>::max)()) {
+         ec = error::not_a_number;
+         return;
+      }
+
+      i = static_cast<T>(v);
+   } else {
+      auto const v = resp3::detail::parse_uint(sv.data(), sv.size(), ec);
+      if (ec)
+         return;
+
+      if (v > (std::numeric_limits<T>::max)()) {
+         ec = error::not_a_number;
+         return;
+      }
+
+      i = static_cast<T>(v);
+   }
 }
 
 inline
@@ -72,7 +82,7 @@ void from_bulk(
    boost::string_view sv,
    boost::system::error_code& ec)
 {
-   d = parse_double(sv.data(), sv.size(), ec);
+   d = resp3::detail::parse_double(sv.data(), sv.size(), ec);
 }
 
 template <class CharT, class Traits, class Allocator>
@@ -85,6 +95,89 @@ from_bulk(
   s.append(sv.data(), sv.size());
 }
 
+// Types whose bulk payload can be written in place, see
+// resp3::detail::has_bulk_storage.
+template <class T>
+struct is_bulk_storable : std::false_type {};
+
+template <class Traits, class Allocator>
+struct is_bulk_storable<std::basic_string<char, Traits, Allocator>> : std::true_type {};
+
+// Like from_bulk, appends to the string.
+template <class Traits, class Allocator>
+auto
+bulk_storage(
+   std::basic_string<char, Traits, Allocator>& s,
+   std::size_t size) -> char*
+{
+   auto const n = s.size();
+   s.resize(n + size);
+   return s.data() + n;
+}
+
+// Used in place of the decoded value when the parser delivers the
+// text only.
+struct no_value {};
+
+// Forwards a node to an adapter with or without the decoded value.
+template <class Adapter, class Value>
+void
+forward_node(
+   Adapter& adapter,
+   resp3::node<boost::string_view> const& nd,
+   Value v,
+   boost::system::error_code& ec)
+{
+   if constexpr (std::is_same<Value, no_value>::value)
+      adapter(nd, ec);
+   else
+      resp3::detail::call_adapter(adapter, nd, v, ec);
+}
+
+template <class T>
+void
+from_value(
+   T& t,
+   boost::string_view sv,
+   no_value,
+   boost::system::error_code& ec)
+{
+   from_bulk(t, sv, ec);
+}
+
+// The value has already been decoded by the parser, see
+// resp3::detail::accepts_typed_scalars. Conversions that are not
+// exact fall back to the text.
+template <class T, class V>
+auto
+from_value(
+   T& t,
+   boost::string_view sv,
+   V v,
+   boost::system::error_code& ec) -> typename std::enable_if<std::is_arithmetic<V>::value, void>::type
+{
+   if constexpr (std::is_same<T, V>::value) {
+      t = v;
+   } else if constexpr (std::is_integral<T>::value && !std::is_same<T, bool>::value && std::is_same<V, std::int64_t>::value) {
+      bool in_range = false;
+      if constexpr (std::is_signed<T>::value)
+         in_range = v >= (std::numeric_limits<T>::min)() && v <= (std::numeric_limits<T>::max)();
+      else
+         in_range = v >= 0 && static_cast<std::uint64_t>(v) <= (std::numeric_limits<T>::max)();
+
+      if (!in_range) {
+         ec = error::not_a_number;
+         return;
+      }
+
+      t = static_cast<T>(v);
+   } else if constexpr (std::is_floating_point<T>::value && std::is_same<V, double>::value) {
+      t = static_cast<T>(v);
+   } else {
+      from_bulk(t, sv, ec);
+   }
+}
+
 //================================================
 
 inline
@@ -109,6 +202,19 @@ public:
    {
       result_->push_back({n.data_type, n.aggregate_size, n.depth, std::string{std::cbegin(n.value), std::cend(n.value)}});
    }
+
+   template <
+      class R = Result,
+      class = std::enable_if_t<is_bulk_storable<decltype(std::declval<R&>().back().value)>::value>>
+   auto
+   get_bulk_storage(
+      resp3::node<boost::string_view> const& n,
+      std::size_t size,
+      boost::system::error_code&) -> char*
+   {
+      result_->push_back({n.data_type, n.aggregate_size, n.depth, {}});
+      return bulk_storage(result_->back().value, size);
+   }
 };
 
 template <class Node>
@@ -129,15 +235,84 @@ public:
    }
 };
 
+class view_adapter {
+private:
+   resp3::response_view* result_;
+
+public:
+   explicit view_adapter(resp3::response_view* v = nullptr): result_(v) {}
+
+   void operator()(resp3::node<boost::string_view> const& nd, boost::system::error_code&)
+      { result_->push_back(nd); }
+
+   auto
+   get_bulk_storage(
+      resp3::node<boost::string_view> const& nd,
+      std::size_t size,
+      boost::system::error_code&) -> char*
+   {
+      return result_->push_back(nd, size);
+   }
+};
+
+// Response type that passes the values it receives to a callback,
+// see aedis::sink.
+template <class Callback>
+struct sink {
+   Callback callback;
+};
+
+template <class Callback>
+class sink_adapter {
+private:
+   sink<Callback>* sink_;
+
+public:
+   explicit sink_adapter(sink<Callback>* s = nullptr) : sink_(s) {}
+
+   void operator()(resp3::node<boost::string_view> const& nd, boost::system::error_code& ec)
+   {
+      set_on_resp3_error(nd.data_type, ec);
+      if (ec || is_aggregate(nd.data_type))
+         return;
+
+      // The parts of a streamed string are chunks of one value that
+      // ends with an empty part.
+      auto const last = nd.data_type != resp3::type::streamed_string_part || nd.value.empty();
+      sink_->callback(nd.value, last, ec);
+   }
+
+   auto
+   begin_bulk_chunks(
+      resp3::node<boost::string_view> const&,
+      std::size_t,
+      boost::system::error_code&) noexcept -> bool
+   {
+      return true;
+   }
+
+   void
+   on_bulk_chunk(
+      resp3::node<boost::string_view> const& nd,
+      std::size_t remaining,
+      boost::system::error_code& ec)
+   {
+      auto const last = remaining == 0 && nd.data_type != resp3::type::streamed_string_part;
+      sink_->callback(nd.value, last, ec);
+   }
+};
+
 template <class Result>
 class simple_impl {
 public:
    void on_value_available(Result&) {}
 
+   template <class Value>
    void
    operator()(
       Result& result,
       resp3::node<boost::string_view> const& n,
+      Value v,
       boost::system::error_code& ec)
    {
       set_on_resp3_error(n.data_type, ec);
@@ -149,7 +324,18 @@ public:
          return;
       }
 
-      from_bulk(result, n.value, ec);
+      from_value(result, n.value, v, ec);
+   }
+
+   template <class R = Result, class = std::enable_if_t<is_bulk_storable<R>::value>>
+   auto
+   get_bulk_storage(
+      Result& result,
+      resp3::node<boost::string_view> const&,
+      std::size_t size,
+      boost::system::error_code&) -> char*
+   {
+      return bulk_storage(result, size);
    }
 };
 
@@ -162,10 +348,12 @@ public:
    void on_value_available(Result& result)
       { hint_ = std::end(result); }
 
+   template <class Value>
    void
    operator()(
       Result& result,
       resp3::node<boost::string_view> const& nd,
+      Value v,
       boost::system::error_code& ec)
    {
       set_on_resp3_error(nd.data_type, ec);
@@ -186,7 +374,7 @@ public:
       }
 
       typename Result::key_type obj;
-      from_bulk(obj, nd.value, ec);
+      from_value(obj, nd.value, v, ec);
       hint_ = result.insert(hint_, std::move(obj));
    }
 };
@@ -201,10 +389,12 @@ public:
    void on_value_available(Result& result)
       { current_ = std::end(result); }
 
+   template <class Value>
    void
    operator()(
       Result& result,
       resp3::node<boost::string_view> const& nd,
+      Value v,
       boost::system::error_code& ec)
    {
       set_on_resp3_error(nd.data_type, ec);
@@ -226,11 +416,11 @@ public:
 
       if (on_key_) {
          typename Result::key_type obj;
-         from_bulk(obj, nd.value, ec);
+         from_value(obj, nd.value, v, ec);
          current_ = result.insert(current_, {std::move(obj), {}});
       } else {
          typename Result::mapped_type obj;
-         from_bulk(obj, nd.value, ec);
+         from_value(obj, nd.value, v, ec);
          current_->second = std::move(obj);
       }
 
@@ -243,10 +433,12 @@ class vector_impl {
 public:
    void on_value_available(Result& ) { }
 
+   template <class Value>
    void
    operator()(
       Result& result,
       resp3::node<boost::string_view> const& nd,
+      Value v,
       boost::system::error_code& ec)
    {
       set_on_resp3_error(nd.data_type, ec);
@@ -258,9 +450,23 @@ public:
          result.reserve(result.size() + m * nd.aggregate_size);
       } else {
          result.push_back({});
-         from_bulk(result.back(), nd.value, ec);
+         from_value(result.back(), nd.value, v, ec);
       }
    }
+
+   template <
+      class R = Result,
+      class = std::enable_if_t<is_bulk_storable<typename R::value_type>::value>>
+   auto
+   get_bulk_storage(
+      Result& result,
+      resp3::node<boost::string_view> const&,
+      std::size_t size,
+      boost::system::error_code&) -> char*
+   {
+      result.push_back({});
+      return bulk_storage(result.back(), size);
+   }
 };
 
 template <class Result>
@@ -271,10 +477,12 @@ private:
 public:
    void on_value_available(Result& ) { }
 
+   template <class Value>
    void
    operator()(
       Result& result,
       resp3::node<boost::string_view> const& nd,
+      Value v,
       boost::system::error_code& ec)
    {
       set_on_resp3_error(nd.data_type, ec);
@@ -298,7 +506,7 @@ public:
          }
 
          BOOST_ASSERT(nd.aggregate_size == 1);
-         from_bulk(result.at(i_), nd.value, ec);
+         from_value(result.at(i_), nd.value, v, ec);
       }
 
       ++i_;
@@ -310,10 +518,12 @@ struct list_impl {
 
    void on_value_available(Result& ) { }
 
+   template <class Value>
    void
    operator()(
       Result& result,
       resp3::node<boost::string_view> const& nd,
+      Value v,
       boost::system::error_code& ec)
    {
       set_on_resp3_error(nd.data_type, ec);
@@ -328,8 +538,27 @@ struct list_impl {
         }
 
         result.push_back({});
-        from_bulk(result.back(), nd.value, ec);
+        from_value(result.back(), nd.value, v, ec);
+      }
+   }
+
+   template <
+      class R = Result,
+      class = std::enable_if_t<is_bulk_storable<typename R::value_type>::value>>
+   auto
+   get_bulk_storage(
+      Result& result,
+      resp3::node<boost::string_view> const& nd,
+      std::size_t size,
+      boost::system::error_code& ec) -> char*
+   {
+      if (nd.depth < 1) {
+         ec = error::expects_resp3_aggregate;
+         return nullptr;
       }
+
+      result.push_back({});
+      return bulk_storage(result.back(), size);
    }
 };
 
@@ -379,8 +608,10 @@ struct impl_map<std::deque<T, Allocator>> { using type = list_impl<std::deque<T,
 template <class Result>
 class wrapper {
 private:
+   using impl_type = typename impl_map<Result>::type;
+
    Result* result_;
-   typename impl_map<Result>::type impl_;
+   impl_type impl_;
 
 public:
    explicit wrapper(Result* t = nullptr) : result_(t)
@@ -392,15 +623,41 @@ public:
       boost::system::error_code& ec)
    {
       BOOST_ASSERT(result_);
-      impl_(*result_, nd, ec);
+      impl_(*result_, nd, no_value{}, ec);
+   }
+
+   template <class Value>
+   void
+   operator()(
+      resp3::node<boost::string_view> const& nd,
+      Value v,
+      boost::system::error_code& ec)
+   {
+      BOOST_ASSERT(result_);
+      impl_(*result_, nd, v, ec);
+   }
+
+   template <
+      class I = impl_type,
+      class = decltype(std::declval<I&>().get_bulk_storage(std::declval<Result&>(), std::declval<resp3::node<boost::string_view> const&>(), std::size_t{}, std::declval<boost::system::error_code&>()))>
+   auto
+   get_bulk_storage(
+      resp3::node<boost::string_view> const& nd,
+      std::size_t size,
+      boost::system::error_code& ec) -> char*
+   {
+      BOOST_ASSERT(result_);
+      return impl_.get_bulk_storage(*result_, nd, size, ec);
    }
 };
 
 template <class T>
 class wrapper<std::optional<T>> {
 private:
+   using impl_type = typename impl_map<T>::type;
+
    std::optional<T>* result_;
-   typename impl_map<T>::type impl_{};
+   impl_type impl_{};
 
 public:
    explicit wrapper(std::optional<T>* o = nullptr) : result_(o) {}
@@ -409,6 +666,16 @@ public:
    operator()(
       resp3::node<boost::string_view> const& nd,
       boost::system::error_code& ec)
+   {
+      (*this)(nd, no_value{}, ec);
+   }
+
+   template <class Value>
+   void
+   operator()(
+      resp3::node<boost::string_view> const& nd,
+      Value v,
+      boost::system::error_code& ec)
    {
       if (nd.data_type == resp3::type::null)
          return;
@@ -418,7 +685,24 @@ public:
         impl_.on_value_available(result_->value());
       }
 
-      impl_(result_->value(), nd, ec);
+      impl_(result_->value(), nd, v, ec);
+   }
+
+   template <
+      class I = impl_type,
+      class = decltype(std::declval<I&>().get_bulk_storage(std::declval<T&>(), std::declval<resp3::node<boost::string_view> const&>(), std::size_t{}, std::declval<boost::system::error_code&>()))>
+   auto
+   get_bulk_storage(
+      resp3::node<boost::string_view> const& nd,
+      std::size_t size,
+      boost::system::error_code& ec) -> char*
+   {
+      if (!result_->has_value()) {
+        *result_ = T{};
+        impl_.on_value_available(result_->value());
+      }
+
+      return impl_.get_bulk_storage(result_->value(), nd, size, ec);
    }
 };
 
@@ -54,6 +54,20 @@ struct response_traits<std::vector<resp3::node<String>, Allocator>> {
    static auto adapt(response_type& v) noexcept { return adapter_type{&v}; }
 };
 
+template <>
+struct response_traits<resp3::response_view> {
+   using response_type = resp3::response_view;
+   using adapter_type = adapter::detail::view_adapter;
+   static auto adapt(response_type& v) noexcept { return adapter_type{&v}; }
+};
+
+template <class Callback>
+struct response_traits<sink<Callback>> {
+   using response_type = sink<Callback>;
+   using adapter_type = adapter::detail::sink_adapter<Callback>;
+   static auto adapt(response_type& s) noexcept { return adapter_type{&s}; }
+};
+
 template <>
 struct response_traits<void> {
    using response_type = void;
@@ -64,6 +78,70 @@ struct response_traits<void> {
 template <class T>
 using adapter_t = typename response_traits<std::decay_t<T>>::adapter_type;
 
+template <class T>
+using accepts_typed_scalars_t = resp3::detail::accepts_typed_scalars<adapter_t<T>>;
+
+// True if any of the elements of the tuple wants typed scalars.
+template <class Tuple>
+using any_accepts_typed_scalars = boost::mp11::mp_any_of<Tuple, accepts_typed_scalars_t>;
+
+template <class T>
+using has_bulk_storage_t = resp3::detail::has_bulk_storage<adapter_t<T>>;
+
+// True if any of the elements of the tuple can store bulks in place.
+template <class Tuple>
+using any_has_bulk_storage = boost::mp11::mp_any_of<Tuple, has_bulk_storage_t>;
+
+template <class T>
+using has_bulk_sink_t = resp3::detail::has_bulk_sink<adapter_t<T>>;
+
+// True if any of the elements of the tuple consumes bulks in chunks.
+template <class Tuple>
+using any_has_bulk_sink = boost::mp11::mp_any_of<Tuple, has_bulk_sink_t>;
+
+// Returns true if the adapter wants the bulk in chunks.
+template <class Adapter>
+auto
+begin_bulk_chunks(
+   Adapter& adapter,
+   resp3::node<boost::string_view> const& nd,
+   std::size_t size,
+   boost::system::error_code& ec) -> bool
+{
+   if constexpr (resp3::detail::has_bulk_sink<Adapter>::value)
+      return adapter.begin_bulk_chunks(nd, size, ec);
+   else
+      return false;
+}
+
+template <class Adapter>
+void
+on_bulk_chunk(
+   Adapter& adapter,
+   resp3::node<boost::string_view> const& nd,
+   std::size_t remaining,
+   boost::system::error_code& ec)
+{
+   if constexpr (resp3::detail::has_bulk_sink<Adapter>::value)
+      adapter.on_bulk_chunk(nd, remaining, ec);
+}
+
+// Returns the storage offered by the adapter or null if it doesn't
+// support it.
+template <class Adapter>
+auto
+get_bulk_storage(
+   Adapter& adapter,
+   resp3::node<boost::string_view> const& nd,
+   std::size_t size,
+   boost::system::error_code& ec) -> char*
+{
+   if constexpr (resp3::detail::has_bulk_storage<Adapter>::value)
+      return adapter.get_bulk_storage(nd, size, ec);
+   else
+      return nullptr;
+}
+
 // Duplicated here to avoid circular include dependency.
 template<class T>
 auto internal_adapt(T& t) noexcept
@@ -109,6 +187,7 @@ public:
       detail::assigner<std::tuple_size<Tuple>::value - 1>::assign(adapters_, *r);
    }
 
+private:
    void count(resp3::node<boost::string_view> const& nd)
    {
       if (nd.depth == 1) {
@@ -124,9 +203,11 @@ public:
          ++i_;
    }
 
+   template <class Value>
    void
-   operator()(
+   on_node(
       resp3::node<boost::string_view> const& nd,
+      Value v,
       boost::system::error_code& ec)
    {
       using boost::variant2::visit;
@@ -139,9 +220,85 @@ public:
          return;
       }
 
-      visit([&](auto& arg){arg(nd, ec);}, adapters_[i_]);
+      visit([&](auto& arg){forward_node(arg, nd, v, ec);}, adapters_[i_]);
       count(nd);
    }
+
+public:
+   void
+   operator()(
+      resp3::node<boost::string_view> const& nd,
+      boost::system::error_code& ec)
+   {
+      on_node(nd, no_value{}, ec);
+   }
+
+   template <
+      class Value,
+      bool B = any_accepts_typed_scalars<Tuple>::value,
+      class = std::enable_if_t<B>>
+   void
+   operator()(
+      resp3::node<boost::string_view> const& nd,
+      Value v,
+      boost::system::error_code& ec)
+   {
+      on_node(nd, v, ec);
+   }
+
+   template <
+      bool B = any_has_bulk_storage<Tuple>::value,
+      class = std::enable_if_t<B>>
+   auto
+   get_bulk_storage(
+      resp3::node<boost::string_view> const& nd,
+      std::size_t size,
+      boost::system::error_code& ec) -> char*
+   {
+      using boost::variant2::visit;
+
+      if (nd.depth == 0)
+         return nullptr;
+
+      auto* const p = visit([&](auto& arg){return detail::get_bulk_storage(arg, nd, size, ec);}, adapters_[i_]);
+      if (p != nullptr)
+         count(nd);
+
+      return p;
+   }
+
+   template <
+      bool B = any_has_bulk_sink<Tuple>::value,
+      class = std::enable_if_t<B>>
+   auto
+   begin_bulk_chunks(
+      resp3::node<boost::string_view> const& nd,
+      std::size_t size,
+      boost::system::error_code& ec) -> bool
+   {
+      using boost::variant2::visit;
+
+      if (nd.depth == 0)
+         return false;
+
+      return visit([&](auto& arg){return detail::begin_bulk_chunks(arg, nd, size, ec);}, adapters_[i_]);
+   }
+
+   template <
+      bool B = any_has_bulk_sink<Tuple>::value,
+      class = std::enable_if_t<B>>
+   void
+   on_bulk_chunk(
+      resp3::node<boost::string_view> const& nd,
+      std::size_t remaining,
+      boost::system::error_code& ec)
+   {
+      using boost::variant2::visit;
+
+      visit([&](auto& arg){detail::on_bulk_chunk(arg, nd, remaining, ec);}, adapters_[i_]);
+      if (remaining == 0)
+         count(nd);
+   }
 };
 
 template <class... Ts>
@@ -0,0 +1,654 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_COMMAND_HPP
+#define AEDIS_COMMAND_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+
+#include <boost/utility/string_view.hpp>
+
+namespace aedis::cmd {
+
+/** \brief Metadata of a Redis command.
+ *  \ingroup high-level-api
+ *
+ *  Key positions follow the output of `COMMAND INFO`: they are
+ *  indices in the argument list where the command name is at
+ *  position zero, a negative last_key counts from the end and
+ *  first_key is zero for commands without keys or whose keys can't
+ *  be known without parsing the arguments, see has_movable_keys().
+ */
+struct info {
+   /// Flag bits.
+   static constexpr std::uint8_t readonly = 1;
+   static constexpr std::uint8_t write = 2;
+   static constexpr std::uint8_t blocking = 4;
+   static constexpr std::uint8_t push_response = 8;
+   static constexpr std::uint8_t movable_keys = 16;
+   static constexpr std::uint8_t splittable = 32;
+
+   /// The command name in upper case.
+   char const* name;
+
+   /// Bitwise or of the flag bits.
+   std::uint8_t flags;
+
+   /// The position of the first key.
+   std::int8_t first_key;
+
+   /// The position of the last key.
+   std::int8_t last_key;
+
+   /// The distance between keys, e.g. 2 for MSET.
+   std::int8_t key_step;
+
+   /// True if the command doesn't modify data, e.g. GET.
+   constexpr auto is_readonly() const noexcept -> bool
+      { return flags & readonly; }
+
+   /// True if the command may modify data, e.g. SET.
+   constexpr auto is_write() const noexcept -> bool
+      { return flags & write; }
+
+   /// True if the command may block the connection, e.g. BLPOP.
+   constexpr auto is_blocking() const noexcept -> bool
+      { return flags & blocking; }
+
+   /** \brief True if Redis responds to the command with pushes
+    *  instead of a reply, e.g. SUBSCRIBE.
+    */
+   constexpr auto has_push_response() const noexcept -> bool
+      { return flags & push_response; }
+
+   /// True if the keys depend on the arguments, e.g. EVAL.
+   constexpr auto has_movable_keys() const noexcept -> bool
+      { return flags & movable_keys; }
+
+   /** \brief True if the command applied to a range of elements has
+    *  the same effect as several commands of the same kind applied to
+    *  parts of it, e.g. SADD, see
+    *  resp3::request::config::max_range_size.
+    */
+   constexpr auto is_splittable() const noexcept -> bool
+      { return flags & splittable; }
+
+   /// True if the command may take more than one key.
+   constexpr auto is_multi_key() const noexcept -> bool
+      { return has_movable_keys() || (first_key != 0 && last_key != first_key); }
+};
+
+namespace detail {
+
+constexpr auto length(char const* s) noexcept -> std::size_t
+{
+   std::size_t n = 0;
+   for (; s[n] != '\0'; ++n);
+   return n;
+}
+
+constexpr auto to_upper(char c) noexcept -> char
+   { return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c; }
+
+// Case insensitive comparison with an upper case name.
+constexpr auto iequals(boost::string_view a, char const* upper) noexcept -> bool
+{
+   std::size_t i = 0;
+   for (; i < a.size() && upper[i] != '\0'; ++i) {
+      if (to_upper(a[i]) != upper[i])
+         return false;
+   }
+
+   return i == a.size() && upper[i] == '\0';
+}
+
+// FNV-1a on the case folded name.
+constexpr auto hash(boost::string_view name, std::uint32_t seed) noexcept -> std::uint32_t
+{
+   std::uint32_t h = 2166136261U + seed;
+   for (std::size_t i = 0; i < name.size(); ++i) {
+      h ^= static_cast<unsigned char>(name[i]) | 0x20U;
+      h *= 16777619U;
+   }
+
+   return h ^ (h >> 15);
+}
+
+// Redis 7 commands, subcommands like CLIENT LIST are not included.
+inline constexpr info commands[] =
+{
+   {"COPY", info::write, 1, 2, 1},
+   {"DEL", info::write | info::splittable, 1, -1, 1},
+   {"DUMP", info::readonly, 1, 1, 1},
+   {"EXISTS", info::readonly | info::splittable, 1, -1, 1},
+   {"EXPIRE", info::write, 1, 1, 1},
+   {"EXPIREAT", info::write, 1, 1, 1},
+   {"EXPIRETIME", info::readonly, 1, 1, 1},
+   {"KEYS", info::readonly, 0, 0, 0},
+   {"MIGRATE", info::write | info::movable_keys, 3, 3, 1},
+   {"MOVE", info::write, 1, 1, 1},
+   {"OBJECT", 0, 0, 0, 0},
+   {"PERSIST", info::write, 1, 1, 1},
+   {"PEXPIRE", info::write, 1, 1, 1},
+   {"PEXPIREAT", info::write, 1, 1, 1},
+   {"PEXPIRETIME", info::readonly, 1, 1, 1},
+   {"PTTL", info::readonly, 1, 1, 1},
+   {"RANDOMKEY", info::readonly, 0, 0, 0},
+   {"RENAME", info::write, 1, 2, 1},
+   {"RENAMENX", info::write, 1, 2, 1},
+   {"RESTORE", info::write, 1, 1, 1},
+   {"SCAN", info::readonly, 0, 0, 0},
+   {"SORT", info::write | info::movable_keys, 1, 1, 1},
+   {"SORT_RO", info::readonly, 1, 1, 1},
+   {"TOUCH", info::readonly | info::splittable, 1, -1, 1},
+   {"TTL", info::readonly, 1, 1, 1},
+   {"TYPE", info::readonly, 1, 1, 1},
+   {"UNLINK", info::write | info::splittable, 1, -1, 1},
+   {"WAIT", info::blocking, 0, 0, 0},
+   {"WAITAOF", info::blocking, 0, 0, 0},
+   {"APPEND", info::write, 1, 1, 1},
+   {"DECR", info::write, 1, 1, 1},
+   {"DECRBY", info::write, 1, 1, 1},
+   {"GET", info::readonly, 1, 1, 1},
+   {"GETDEL", info::write, 1, 1, 1},
+   {"GETEX", info::write, 1, 1, 1},
+   {"GETRANGE", info::readonly, 1, 1, 1},
+   {"GETSET", info::write, 1, 1, 1},
+   {"INCR", info::write, 1, 1, 1},
+   {"INCRBY", info::write, 1, 1, 1},
+   {"INCRBYFLOAT", info::write, 1, 1, 1},
+   {"LCS", info::readonly, 1, 2, 1},
+   {"MGET", info::readonly | info::splittable, 1, -1, 1},
+   {"MSET", info::write | info::splittable, 1, -1, 2},
+   {"MSETNX", info::write, 1, -1, 2},
+   {"PSETEX", info::write, 1, 1, 1},
+   {"SET", info::write, 1, 1, 1},
+   {"SETEX", info::write, 1, 1, 1},
+   {"SETNX", info::write, 1, 1, 1},
+   {"SETRANGE", info::write, 1, 1, 1},
+   {"STRLEN", info::readonly, 1, 1, 1},
+   {"SUBSTR", info::readonly, 1, 1, 1},
+   {"HDEL", info::write | info::splittable, 1, 1, 1},
+   {"HEXISTS", info::readonly, 1, 1, 1},
+   {"HGET", info::readonly, 1, 1, 1},
+   {"HGETALL", info::readonly, 1, 1, 1},
+   {"HINCRBY", info::write, 1, 1, 1},
+   {"HINCRBYFLOAT", info::write, 1, 1, 1},
+   {"HKEYS", info::readonly, 1, 1, 1},
+   {"HLEN", info::readonly, 1, 1, 1},
+   {"HMGET", info::readonly | info::splittable, 1, 1, 1},
+   {"HMSET", info::write | info::splittable, 1, 1, 1},
+   {"HRANDFIELD", info::readonly, 1, 1, 1},
+   {"HSCAN", info::readonly, 1, 1, 1},
+   {"HSET", info::write | info::splittable, 1, 1, 1},
+   {"HSETNX", info::write, 1, 1, 1},
+   {"HSTRLEN", info::readonly, 1, 1, 1},
+   {"HVALS", info::readonly, 1, 1, 1},
+   {"BLMOVE", info::write | info::blocking, 1, 2, 1},
+   {"BLMPOP", info::write | info::blocking | info::movable_keys, 0, 0, 0},
+   {"BLPOP", info::write | info::blocking, 1, -2, 1},
+   {"BRPOP", info::write | info::blocking, 1, -2, 1},
+   {"BRPOPLPUSH", info::write | info::blocking, 1, 2, 1},
+   {"LINDEX", info::readonly, 1, 1, 1},
+   {"LINSERT", info::write, 1, 1, 1},
+   {"LLEN", info::readonly, 1, 1, 1},
+   {"LMOVE", info::write, 1, 2, 1},
+   {"LMPOP", info::write | info::movable_keys, 0, 0, 0},
+   {"LPOP", info::write, 1, 1, 1},
+   {"LPOS", info::readonly, 1, 1, 1},
+   {"LPUSH", info::write | info::splittable, 1, 1, 1},
+   {"LPUSHX", info::write | info::splittable, 1, 1, 1},
+   {"LRANGE", info::readonly, 1, 1, 1},
+   {"LREM", info::write, 1, 1, 1},
+   {"LSET", info::write, 1, 1, 1},
+   {"LTRIM", info::write, 1, 1, 1},
+   {"RPOP", info::write, 1, 1, 1},
+   {"RPOPLPUSH", info::write, 1, 2, 1},
+   {"RPUSH", info::write | info::splittable, 1, 1, 1},
+   {"RPUSHX", info::write | info::splittable, 1, 1, 1},
+   {"SADD", info::write | info::splittable, 1, 1, 1},
+   {"SCARD", info::readonly, 1, 1, 1},
+   {"SDIFF", info::readonly, 1, -1, 1},
+   {"SDIFFSTORE", info::write, 1, -1, 1},
+   {"SINTER", info::readonly, 1, -1, 1},
+   {"SINTERCARD", info::readonly | info::movable_keys, 0, 0, 0},
+   {"SINTERSTORE", info::write, 1, -1, 1},
+   {"SISMEMBER", info::readonly, 1, 1, 1},
+   {"SMEMBERS", info::readonly, 1, 1, 1},
+   {"SMISMEMBER", info::readonly | info::splittable, 1, 1, 1},
+   {"SMOVE", info::write, 1, 2, 1},
+   {"SPOP", info::write, 1, 1, 1},
+   {"SRANDMEMBER", info::readonly, 1, 1, 1},
+   {"SREM", info::write | info::splittable, 1, 1, 1},
+   {"SSCAN", info::readonly, 1, 1, 1},
+   {"SUNION", info::readonly, 1, -1, 1},
+   {"SUNIONSTORE", info::write, 1, -1, 1},
+   {"BZMPOP", info::write | info::blocking | info::movable_keys, 0, 0, 0},
+   {"BZPOPMAX", info::write | info::blocking, 1, -2, 1},
+   {"BZPOPMIN", info::write | info::blocking, 1, -2, 1},
+   {"ZADD", info::write | info::splittable, 1, 1, 1},
+   {"ZCARD", info::readonly, 1, 1, 1},
+   {"ZCOUNT", info::readonly, 1, 1, 1},
+   {"ZDIFF", info::readonly | info::movable_keys, 0, 0, 0},
+   {"ZDIFFSTORE", info::write | info::movable_keys, 1, 1, 1},
+   {"ZINCRBY", info::write, 1, 1, 1},
+   {"ZINTER", info::readonly | info::movable_keys, 0, 0, 0},
+   {"ZINTERCARD", info::readonly | info::movable_keys, 0, 0, 0},
+   {"ZINTERSTORE", info::write | info::movable_keys, 1, 1, 1},
+   {"ZLEXCOUNT", info::readonly, 1, 1, 1},
+   {"ZMPOP", info::write | info::movable_keys, 0, 0, 0},
+   {"ZMSCORE", info::readonly | info::splittable, 1, 1, 1},
+   {"ZPOPMAX", info::write, 1, 1, 1},
+   {"ZPOPMIN", info::write, 1, 1, 1},
+   {"ZRANDMEMBER", info::readonly, 1, 1, 1},
+   {"ZRANGE", info::readonly, 1, 1, 1},
+   {"ZRANGEBYLEX", info::readonly, 1, 1, 1},
+   {"ZRANGEBYSCORE", info::readonly, 1, 1, 1},
+   {"ZRANGESTORE", info::write, 1, 2, 1},
+   {"ZRANK", info::readonly, 1, 1, 1},
+   {"ZREM", info::write | info::splittable, 1, 1, 1},
+   {"ZREMRANGEBYLEX", info::write, 1, 1, 1},
+   {"ZREMRANGEBYRANK", info::write, 1, 1, 1},
+   {"ZREMRANGEBYSCORE", info::write, 1, 1, 1},
+   {"ZREVRANGE", info::readonly, 1, 1, 1},
+   {"ZREVRANGEBYLEX", info::readonly, 1, 1, 1},
+   {"ZREVRANGEBYSCORE", info::readonly, 1, 1, 1},
+   {"ZREVRANK", info::readonly, 1, 1, 1},
+   {"ZSCAN", info::readonly, 1, 1, 1},
+   {"ZSCORE", info::readonly, 1, 1, 1},
+   {"ZUNION", info::readonly | info::movable_keys, 0, 0, 0},
+   {"ZUNIONSTORE", info::write | info::movable_keys, 1, 1, 1},
+   {"XACK", info::write, 1, 1, 1},
+   {"XADD", info::write, 1, 1, 1},
+   {"XAUTOCLAIM", info::write, 1, 1, 1},
+   {"XCLAIM", info::write, 1, 1, 1},
+   {"XDEL", info::write, 1, 1, 1},
+   {"XGROUP", 0, 0, 0, 0},
+   {"XINFO", 0, 0, 0, 0},
+   {"XLEN", info::readonly, 1, 1, 1},
+   {"XPENDING", info::readonly, 1, 1, 1},
+   {"XRANGE", info::readonly, 1, 1, 1},
+   {"XREAD", info::readonly | info::blocking | info::movable_keys, 0, 0, 0},
+   {"XREADGROUP", info::write | info::blocking | info::movable_keys, 0, 0, 0},
+   {"XREVRANGE", info::readonly, 1, 1, 1},
+   {"XSETID", info::write, 1, 1, 1},
+   {"XTRIM", info::write, 1, 1, 1},
+   {"BITCOUNT", info::readonly, 1, 1, 1},
+   {"BITFIELD", info::write, 1, 1, 1},
+   {"BITFIELD_RO", info::readonly, 1, 1, 1},
+   {"BITOP", info::write, 2, -1, 1},
+   {"BITPOS", info::readonly, 1, 1, 1},
+   {"GETBIT", info::readonly, 1, 1, 1},
+   {"SETBIT", info::write, 1, 1, 1},
+   {"PFADD", info::write | info::splittable, 1, 1, 1},
+   {"PFCOUNT", info::readonly, 1, -1, 1},
+   {"PFMERGE", info::write, 1, -1, 1},
+   {"GEOADD", info::write | info::splittable, 1, 1, 1},
+   {"GEODIST", info::readonly, 1, 1, 1},
+   {"GEOHASH", info::readonly | info::splittable, 1, 1, 1},
+   {"GEOPOS", info::readonly | info::splittable, 1, 1, 1},
+   {"GEORADIUS", info::write | info::movable_keys, 1, 1, 1},
+   {"GEORADIUSBYMEMBER", info::write | info::movable_keys, 1, 1, 1},
+   {"GEORADIUSBYMEMBER_RO", info::readonly, 1, 1, 1},
+   {"GEORADIUS_RO", info::readonly, 1, 1, 1},
+   {"GEOSEARCH", info::readonly, 1, 1, 1},
+   {"GEOSEARCHSTORE", info::write, 1, 2, 1},
+   {"PSUBSCRIBE", info::push_response, 0, 0, 0},
+   {"PUBLISH", 0, 0, 0, 0},
+   {"PUBSUB", 0, 0, 0, 0},
+   {"PUNSUBSCRIBE", info::push_response, 0, 0, 0},
+   {"SPUBLISH", 0, 1, 1, 1},
+   {"SSUBSCRIBE", info::push_response, 1, -1, 1},
+   {"SUBSCRIBE", info::push_response, 0, 0, 0},
+   {"SUNSUBSCRIBE", info::push_response, 1, -1, 1},
+   {"UNSUBSCRIBE", info::push_response, 0, 0, 0},
+   {"DISCARD", 0, 0, 0, 0},
+   {"EXEC", 0, 0, 0, 0},
+   {"MULTI", 0, 0, 0, 0},
+   {"UNWATCH", 0, 0, 0, 0},
+   {"WATCH", 0, 1, -1, 1},
+   {"EVAL", info::movable_keys, 0, 0, 0},
+   {"EVALSHA", info::movable_keys, 0, 0, 0},
+   {"EVALSHA_RO", info::readonly | info::movable_keys, 0, 0, 0},
+   {"EVAL_RO", info::readonly | info::movable_keys, 0, 0, 0},
+   {"FCALL", info::movable_keys, 0, 0, 0},
+   {"FCALL_RO", info::readonly | info::movable_keys, 0, 0, 0},
+   {"FUNCTION", 0, 0, 0, 0},
+   {"SCRIPT", 0, 0, 0, 0},
+   {"AUTH", 0, 0, 0, 0},
+   {"CLIENT", 0, 0, 0, 0},
+   {"ECHO", 0, 0, 0, 0},
+   {"HELLO", 0, 0, 0, 0},
+   {"PING", 0, 0, 0, 0},
+   {"QUIT", 0, 0, 0, 0},
+   {"RESET", 0, 0, 0, 0},
+   {"SELECT", 0, 0, 0, 0},
+   {"ACL", 0, 0, 0, 0},
+   {"BGREWRITEAOF", 0, 0, 0, 0},
+   {"BGSAVE", 0, 0, 0, 0},
+   {"COMMAND", 0, 0, 0, 0},
+   {"CONFIG", 0, 0, 0, 0},
+   {"DBSIZE", info::readonly, 0, 0, 0},
+   {"DEBUG", 0, 0, 0, 0},
+   {"FAILOVER", 0, 0, 0, 0},
+   {"FLUSHALL", info::write, 0, 0, 0},
+   {"FLUSHDB", info::write, 0, 0, 0},
+   {"INFO", 0, 0, 0, 0},
+   {"LASTSAVE", 0, 0, 0, 0},
+   {"LATENCY", 0, 0, 0, 0},
+   {"LOLWUT", info::readonly, 0, 0, 0},
+   {"MEMORY", 0, 0, 0, 0},
+   {"MODULE", 0, 0, 0, 0},
+   {"MONITOR", 0, 0, 0, 0},
+   {"PSYNC", 0, 0, 0, 0},
+   {"REPLCONF", 0, 0, 0, 0},
+   {"REPLICAOF", 0, 0, 0, 0},
+   {"ROLE", 0, 0, 0, 0},
+   {"SAVE", 0, 0, 0, 0},
+   {"SHUTDOWN", 0, 0, 0, 0},
+   {"SLAVEOF", 0, 0, 0, 0},
+   {"SLOWLOG", 0, 0, 0, 0},
+   {"SWAPDB", info::write, 0, 0, 0},
+   {"SYNC", 0, 0, 0, 0},
+   {"TIME", 0, 0, 0, 0},
+   {"ASKING", 0, 0, 0, 0},
+   {"CLUSTER", 0, 0, 0, 0},
+   {"READONLY", 0, 0, 0, 0},
+   {"READWRITE", 0, 0, 0, 0},
+};
+
+constexpr std::size_t hash_buckets = 64;
+constexpr std::size_t hash_slots = 256;
+constexpr std::size_t max_bucket_size = 16;
+
+static_assert(std::size(commands) < 256);
+
+// A perfect hash in two levels (hash and displace): The name hashed
+// with seed zero selects a bucket, and the name hashed with the seed
+// of the bucket selects a slot that holds the index of the command
+// plus one.
+struct hash_table {
+   std::array<std::uint8_t, hash_buckets> seeds{};
+   std::array<std::uint8_t, hash_slots> slots{};
+};
+
+// Finds the seeds at compile time, starting with the largest
+// buckets. Fails to compile if there is none.
+constexpr auto make_hash_table() -> hash_table
+{
+   std::array<std::array<std::uint8_t, max_bucket_size>, hash_buckets> members{};
+   std::array<std::size_t, hash_buckets> sizes{};
+
+   for (std::size_t i = 0; i < std::size(commands); ++i) {
+      auto const b = hash(commands[i].name, 0) % hash_buckets;
+      if (sizes[b] == max_bucket_size)
+         throw std::logic_error{"aedis::cmd: Bucket too large."};
+
+      members[b][sizes[b]++] = static_cast<std::uint8_t>(i);
+   }
+
+   hash_table t;
+   for (auto size = max_bucket_size; size != 0; --size) {
+      for (std::size_t b = 0; b < hash_buckets; ++b) {
+         if (sizes[b] != size)
+            continue;
+
+         for (std::uint32_t seed = 1;; ++seed) {
+            if (seed == 256)
+               throw std::logic_error{"aedis::cmd: No perfect hash."};
+
+            std::size_t placed = 0;
+            for (; placed < size; ++placed) {
+               auto const i = members[b][placed];
+               auto& slot = t.slots[hash(commands[i].name, seed) % hash_slots];
+               if (slot != 0)
+                  break;
+
+               slot = static_cast<std::uint8_t>(i + 1);
+            }
+
+            if (placed == size) {
+               t.seeds[b] = static_cast<std::uint8_t>(seed);
+               break;
+            }
+
+            // Undoes the partial placement.
+            while (placed != 0) {
+               auto const i = members[b][--placed];
+               t.slots[hash(commands[i].name, seed) % hash_slots] = 0;
+            }
+         }
+      }
+   }
+
+   return t;
+}
+
+inline constexpr hash_table table = make_hash_table();
+
+} // detail
+
+/** \brief Returns the metadata of a command or nullptr if the
+ *  command is unknown.
+ *  \ingroup high-level-api
+ *
+ *  The name is case insensitive. Takes constant time and can be
+ *  used in constant expressions, e.g.
+ *
+ *  @code
+ *  static_assert(cmd::lookup("BLPOP")->is_blocking());
+ *  @endcode
+ */
+constexpr auto lookup(boost::string_view name) noexcept -> info const*
+{
+   auto const seed = detail::table.seeds[detail::hash(name, 0) % detail::hash_buckets];
+   auto const i = detail::table.slots[detail::hash(name, seed) % detail::hash_slots];
+   if (i == 0 || !detail::iequals(name, detail::commands[i - 1].name))
+      return nullptr;
+
+   return &detail::commands[i - 1];
+}
+
+/** \brief A Redis command with a fixed number of arguments.
+ *  \ingroup high-level-api
+ *
+ *  The RESP3 header of the command, e.g. `*3\r\n$3\r\nSET\r\n` for
+ *  \c SET with two arguments, is serialized when the object is
+ *  constructed, which for the constexpr objects in this namespace
+ *  happens at compile time. Passing them to
+ *  aedis::resp3::request::push appends the header with a single
+ *  copy and serializes only the arguments, for example
+ *
+ *  @code
+ *  request req;
+ *  req.push(cmd::set, "key", "value");
+ *  req.push(cmd::hset<2>, "key", "field1", "value1", "field2", "value2");
+ *  @endcode
+ *
+ *  Commands missing in the catalogue can be defined in the same way
+ *
+ *  @code
+ *  constexpr cmd::command<3> zadd{"ZADD"};
+ *  @endcode
+ *
+ *  \tparam Args The number of arguments that follow the command
+ *  name.
+ */
+template <std::size_t Args>
+class command {
+public:
+   /// The maximum size of the serialized header.
+   static constexpr std::size_t max_header_size = 64;
+
+   /** \brief Constructor
+    *
+    *  Fails to compile in constant expressions if the header
+    *  doesn't fit in max_header_size.
+    *
+    *  \param name The command name, e.g. "SET".
+    */
+   constexpr explicit command(char const* name)
+   : info_{lookup(name)}
+   {
+      auto const n = detail::length(name);
+
+      put('*');
+      put_number(1 + Args);
+      put("\r\n");
+      put('$');
+      put_number(n);
+      put("\r\n");
+      name_offset_ = size_;
+      put(name);
+      put("\r\n");
+   }
+
+   /// Returns the serialized header.
+   constexpr auto header() const noexcept -> boost::string_view
+      { return {header_, size_}; }
+
+   /// Returns the command name.
+   constexpr auto name() const noexcept -> boost::string_view
+      { return {header_ + name_offset_, size_ - name_offset_ - 2}; }
+
+   /// Returns the number of arguments that follow the command name.
+   static constexpr auto args() noexcept -> std::size_t
+      { return Args; }
+
+   /// Returns the command metadata, nullptr if the command is unknown.
+   constexpr auto get_info() const noexcept -> info const*
+      { return info_; }
+
+   /// Returns true if Redis responds to this command with a push.
+   constexpr auto has_push_response() const noexcept -> bool
+      { return info_ != nullptr && info_->has_push_response(); }
+
+   /// Returns true if this is the HELLO command.
+   constexpr auto is_hello() const noexcept -> bool
+      { return info_ != nullptr && info_ == lookup("HELLO"); }
+
+private:
+   constexpr void put(char c)
+   {
+      if (size_ == max_header_size)
+         throw std::length_error{"aedis::cmd::command: Name too long."};
+
+      header_[size_++] = c;
+   }
+
+   constexpr void put(char const* s)
+   {
+      for (; *s != '\0'; ++s)
+         put(*s);
+   }
+
+   constexpr void put_number(std::size_t n)
+   {
+      std::size_t div = 1;
+      while (n / div >= 10)
+         div *= 10;
+
+      for (; div != 0; div /= 10)
+         put(static_cast<char>('0' + (n / div) % 10));
+   }
+
+   char header_[max_header_size] = {};
+   std::size_t size_ = 0;
+   std::size_t name_offset_ = 0;
+   info const* info_ = nullptr;
+};
+
+/// HELLO protover, e.g. `req.push(cmd::hello, 3)`.
+inline constexpr command<1> hello{"HELLO"};
+
+/// PING
+inline constexpr command<0> ping{"PING"};
+
+/// QUIT
+inline constexpr command<0> quit{"QUIT"};
+
+/// ECHO message
+inline constexpr command<1> echo{"ECHO"};
+
+/// FLUSHALL
+inline constexpr command<0> flushall{"FLUSHALL"};
+
+/// GET key
+inline constexpr command<1> get{"GET"};
+
+/// SET key value
+inline constexpr command<2> set{"SET"};
+
+/// DEL key
+inline constexpr command<1> del{"DEL"};
+
+/// EXISTS key
+inline constexpr command<1> exists{"EXISTS"};
+
+/// EXPIRE key seconds
+inline constexpr command<2> expire{"EXPIRE"};
+
+/// INCR key
+inline constexpr command<1> incr{"INCR"};
+
+/// INCRBY key increment
+inline constexpr command<2> incrby{"INCRBY"};
+
+/// HGET key field
+inline constexpr command<2> hget{"HGET"};
+
+/// HGETALL key
+inline constexpr command<1> hgetall{"HGETALL"};
+
+/// LRANGE key start stop
+inline constexpr command<3> lrange{"LRANGE"};
+
+/// PUBLISH channel message
+inline constexpr command<2> publish{"PUBLISH"};
+
+/// MGET key [key ...] with N keys.
+template <std::size_t N>
+inline constexpr command<N> mget{"MGET"};
+
+/// MSET key value [key value ...] with N pairs.
+template <std::size_t N>
+inline constexpr command<2 * N> mset{"MSET"};
+
+/// HSET key field value [field value ...] with N pairs.
+template <std::size_t N>
+inline constexpr command<1 + 2 * N> hset{"HSET"};
+
+/// RPUSH key element [element ...] with N elements.
+template <std::size_t N>
+inline constexpr command<1 + N> rpush{"RPUSH"};
+
+/// LPUSH key element [element ...] with N elements.
+template <std::size_t N>
+inline constexpr command<1 + N> lpush{"LPUSH"};
+
+/// SADD key member [member ...] with N members.
+template <std::size_t N>
+inline constexpr command<1 + N> sadd{"SADD"};
+
+/// SUBSCRIBE channel [channel ...] with N channels.
+template <std::size_t N>
+inline constexpr command<N> subscribe{"SUBSCRIBE"};
+
+/// PSUBSCRIBE pattern [pattern ...] with N patterns.
+template <std::size_t N>
+inline constexpr command<N> psubscribe{"PSUBSCRIBE"};
+
+/// UNSUBSCRIBE channel [channel ...] with N channels.
+template <std::size_t N>
+inline constexpr command<N> unsubscribe{"UNSUBSCRIBE"};
+
+} // aedis::cmd
+
+#endif // AEDIS_COMMAND_HPP
@@ -47,6 +47,9 @@ public:
 
    using base_type = detail::connection_base<executor_type, basic_connection<AsyncReadWriteStream>>;
 
+   /// Connection configuration options.
+   using config = typename base_type::config;
+
    /// Constructor
    explicit
    basic_connection(
@@ -66,6 +69,12 @@ public:
    /// Returns the associated executor.
    auto get_executor() {return stream_.get_executor();}
 
+   /// Returns a reference to the config object.
+   auto get_config() noexcept -> config& { return base_type::get_config(); }
+
+   /// Returns a const reference to the config object.
+   auto get_config() const noexcept -> config const& { return base_type::get_config(); }
+
    /// Resets the underlying stream.
    void reset_stream()
    {
@@ -140,6 +149,39 @@ public:
       return base_type::async_exec(req, adapter, std::move(token));
    }
 
+   /** @brief Executes a shared request on the Redis server asynchronously.
+    *
+    *  Same as the overload above but the connection holds a
+    *  reference to the request until the operation completes, so
+    *  callers don't have to keep it alive. The request must not be
+    *  modified while shared, e.g.
+    *
+    *  @code
+    *  auto req = std::make_shared<request>();
+    *  req->push("HGETALL", "config");
+    *  std::shared_ptr<request const> shared = std::move(req);
+    *
+    *  // In many coroutines.
+    *  co_await conn->async_exec(shared, adapt(resp));
+    *  @endcode
+    *
+    *  Requests are written from their own payload, the connection
+    *  keeps a shared request alive in its list of write owners
+    *  (write_owners_) until it has been written and answered, so a
+    *  request queued many times in a batch is written from the same
+    *  memory.
+    */
+   template <
+      class Adapter = detail::response_traits<void>::adapter_type,
+      class CompletionToken = boost::asio::default_completion_token_t<executor_type>>
+   auto async_exec(
+      std::shared_ptr<resp3::request const> req,
+      Adapter adapter = adapt(),
+      CompletionToken token = CompletionToken{})
+   {
+      return base_type::async_exec(std::move(req), adapter, std::move(token));
+   }
+
    /** @brief Receives server side pushes asynchronously.
     *
     *  Users that expect server pushes should call this function in a
@@ -194,7 +236,6 @@ private:
    using this_type = basic_connection<next_layer_type>;
 
    template <class, class> friend class detail::connection_base;
-   template <class, class> friend struct detail::exec_read_op;
    template <class, class> friend struct detail::exec_op;
    template <class, class> friend struct detail::receive_op;
    template <class> friend struct detail::reader_op;
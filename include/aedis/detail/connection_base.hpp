@@ -8,10 +8,16 @@
 #define AEDIS_CONNECTION_BASE_HPP
 
 #include <vector>
+#include <algorithm>
 #include <queue>
+#include <deque>
+#include <new>
+#include <cstddef>
+#include <initializer_list>
 #include <limits>
 #include <chrono>
 #include <memory>
+#include <optional>
 #include <type_traits>
 #include <memory_resource>
 
@@ -19,11 +25,17 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/steady_timer.hpp>
 #include <boost/asio/bind_executor.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/associated_allocator.hpp>
+#include <boost/asio/associated_cancellation_slot.hpp>
 #include <boost/asio/experimental/channel.hpp>
 
 #include <aedis/adapt.hpp>
 #include <aedis/operation.hpp>
+#include <aedis/resp3/write.hpp>
 #include <aedis/resp3/request.hpp>
+#include <aedis/resp3/read_buffer.hpp>
+#include <aedis/detail/intrusive_list.hpp>
 #include <aedis/detail/connection_ops.hpp>
 
 namespace aedis::detail {
@@ -43,21 +55,66 @@ public:
    using executor_type = Executor;
    using this_type = connection_base<Executor, Derived>;
 
+   /// Connection configuration options.
+   struct config {
+      /** \brief The maximum number of commands whose responses may be
+       *  pending before the connection stops writing new requests.
+       *  A batch is always written when no response is pending,
+       *  regardless of its size. Set to one to write a new batch
+       *  only after all responses to the previous one were read.
+       */
+      std::size_t max_in_flight = (std::numeric_limits<std::size_t>::max)();
+
+      /** \brief The maximum time the writer waits for more requests
+       *  before writing a batch, zero disables waiting. The wait ends
+       *  early when the batch reaches max_batch_bytes or
+       *  max_batch_commands.
+       */
+      std::chrono::microseconds max_write_delay{0};
+
+      /** \brief The size in bytes after which no more requests are
+       *  added to a batch. A batch has at least one request,
+       *  regardless of its size.
+       */
+      std::size_t max_batch_bytes = (std::numeric_limits<std::size_t>::max)();
+
+      /** \brief The number of commands after which no more requests
+       *  are added to a batch. A batch has at least one request,
+       *  regardless of its size.
+       */
+      std::size_t max_batch_commands = (std::numeric_limits<std::size_t>::max)();
+
+      /** \brief Adapts the write delay to the rate at which requests
+       *  are executed. The delay is zero while requests arrive less
+       *  often than every max_write_delay, and approaches
+       *  max_write_delay as the rate rises. Until the interval
+       *  between two requests has been measured the writer waits the
+       *  full max_write_delay, so that bursts right after start are
+       *  coalesced.
+       */
+      bool adaptive_write_delay = false;
+   };
+
    explicit
    connection_base(executor_type ex, std::pmr::memory_resource* resource)
    : writer_timer_{ex}
-   , read_timer_{ex}
+   , cork_timer_{ex}
    , push_channel_{ex}
    , read_buffer_{resource}
-   , write_buffer_{resource}
-   , reqs_{resource}
+   , write_batch_{resource}
+   , next_batch_{resource}
+   , write_owners_{resource}
+   , next_owners_{resource}
+   , req_pool_{resource}
    {
       writer_timer_.expires_at(std::chrono::steady_clock::time_point::max());
-      read_timer_.expires_at(std::chrono::steady_clock::time_point::max());
    }
 
    auto get_executor() {return writer_timer_.get_executor();}
 
+   auto get_config() noexcept -> config& { return cfg_; }
+   auto get_config() const noexcept -> config const& { return cfg_; }
+
    auto cancel(operation op) -> std::size_t
    {
       switch (op) {
@@ -68,8 +125,8 @@ public:
          case operation::run:
          {
             derived().close();
-            read_timer_.cancel();
             writer_timer_.cancel();
+            cork_timer_.cancel();
             cancel_on_conn_lost();
 
             return 1U;
@@ -85,48 +142,54 @@ public:
 
    auto cancel_unwritten_requests() -> std::size_t
    {
-      auto f = [](auto const& ptr)
-      {
-         BOOST_ASSERT(ptr != nullptr);
-         return ptr->is_written();
-      };
-
-      auto point = std::stable_partition(std::begin(reqs_), std::end(reqs_), f);
-
-      auto const ret = std::distance(point, std::end(reqs_));
-
-      std::for_each(point, std::end(reqs_), [](auto const& ptr) {
-         ptr->stop();
-      });
+      // Staged and queued requests are referenced by a write batch
+      // and can't be cancelled anymore, only the unstaged ones that
+      // follow them.
+      std::size_t ret = 0;
+      while (first_unstaged_ != nullptr) {
+         auto* info = first_unstaged_;
+         remove_request(info);
+         info->stop();
+         ++ret;
+      }
 
-      reqs_.erase(point, std::end(reqs_));
       return ret;
    }
 
    auto cancel_on_conn_lost() -> std::size_t
    {
-      auto cond = [](auto const& ptr)
+      auto cond = [](auto const* ptr)
       {
          BOOST_ASSERT(ptr != nullptr);
 
          if (ptr->get_request().get_config().cancel_on_connection_lost)
             return false;
 
+         // Part of the response may have been passed to the adapter.
+         if (ptr->get_adapter().is_started())
+            return false;
+
          return !(!ptr->get_request().get_config().retry && ptr->is_written());
       };
 
-      auto point = std::stable_partition(std::begin(reqs_), std::end(reqs_), cond);
-
-      auto const ret = std::distance(point, std::end(reqs_));
+      std::size_t ret = 0;
+      for (auto* info = reqs_.front(); info != nullptr;) {
+         auto* next = reqs_.next(info);
+         if (cond(info)) {
+            info->reset_status();
+         } else {
+            remove_request(info);
+            info->stop();
+            ++ret;
+         }
 
-      std::for_each(point, std::end(reqs_), [](auto const& ptr) {
-         ptr->stop();
-      });
+         info = next;
+      }
 
-      reqs_.erase(point, std::end(reqs_));
-      std::for_each(std::begin(reqs_), std::end(reqs_), [](auto const& ptr) {
-         return ptr->reset_status();
-      });
+      // All remaining requests will be written again.
+      first_staged_ = reqs_.front();
+      first_queued_ = reqs_.front();
+      first_unstaged_ = reqs_.front();
       return ret;
    }
 
@@ -138,7 +201,7 @@ public:
       Adapter adapter = adapt(),
       CompletionToken token = CompletionToken{})
    {
-      BOOST_ASSERT_MSG(req.size() <= adapter.get_supported_response_size(), "Request and adapter have incompatible sizes.");
+      BOOST_ASSERT_MSG(req.responses() <= adapter.get_supported_response_size(), "Request and adapter have incompatible sizes.");
 
       return boost::asio::async_compose
          < CompletionToken
@@ -146,6 +209,24 @@ public:
          >(detail::exec_op<Derived, Adapter>{&derived(), &req, adapter}, token, writer_timer_);
    }
 
+   template <
+      class Adapter = detail::response_traits<void>::adapter_type,
+      class CompletionToken = boost::asio::default_completion_token_t<executor_type>>
+   auto async_exec(
+      std::shared_ptr<resp3::request const> req,
+      Adapter adapter = adapt(),
+      CompletionToken token = CompletionToken{})
+   {
+      BOOST_ASSERT(req != nullptr);
+      BOOST_ASSERT_MSG(req->responses() <= adapter.get_supported_response_size(), "Request and adapter have incompatible sizes.");
+
+      auto const* ptr = req.get();
+      return boost::asio::async_compose
+         < CompletionToken
+         , void(boost::system::error_code, std::size_t)
+         >(detail::exec_op<Derived, Adapter>{&derived(), ptr, adapter, std::move(req)}, token, writer_timer_);
+   }
+
    template <
       class Adapter = detail::response_traits<void>::adapter_type,
       class CompletionToken = boost::asio::default_completion_token_t<executor_type>>
@@ -181,20 +262,34 @@ private:
 
    void on_write()
    {
-      // We have to clear the payload right after writing it to use it
+      // We have to clear the batch right after writing it to use it
       // as a flag that informs there is no ongoing write.
-      write_buffer_.clear();
+      write_batch_.clear();
+      write_owners_.clear();
+
+      // Requests that don't expect a response, e.g. SUBSCRIBE, are
+      // done once written.
+      for (auto* info = first_staged_; info != first_queued_;) {
+         auto* next = reqs_.next(info);
+         if (info->get_request().size() == 0) {
+            remove_request(info);
+            info->proceed();
+         } else {
+            info->mark_written();
+         }
 
-      // Notice this must come before the for-each below.
-      cancel_push_requests();
+         info = next;
+      }
 
-      std::for_each(std::begin(reqs_), std::end(reqs_), [](auto const& ptr) {
-         if (ptr->is_staged())
-            ptr->mark_written();
-      });
+      first_staged_ = first_queued_;
    }
 
-   struct req_info {
+   // The completion record of an async_exec. It stores the handler
+   // of the exec_op while the reader parses the response into the
+   // adapter, and proceed() and stop() post it. Records are pooled by
+   // the connection and reused by later requests, see
+   // acquire_request_info.
+   struct req_info : public intrusive_list_hook<req_info> {
    public:
       enum class action
       {
@@ -203,26 +298,59 @@ private:
          none,
       };
 
-      explicit req_info(resp3::request const& req, executor_type ex)
-      : timer_{ex}
-      , action_{action::none}
-      , req_{&req}
-      , cmds_{std::size(req)}
-      , status_{status::none}
+      explicit req_info(executor_type ex)
+      : ex_{std::move(ex)}
+      { }
+
+      req_info(req_info const&) = delete;
+      auto operator=(req_info const&) -> req_info& = delete;
+
+      ~req_info()
+      {
+         if (complete_ != nullptr)
+            complete_(*this, false, true);
+      }
+
+      void reset(resp3::request const& req, std::shared_ptr<resp3::request const> owner)
+      {
+         action_ = action::none;
+         req_ = &req;
+         owner_ = std::move(owner);
+         cmds_ = std::size(req);
+         status_ = status::none;
+         ec_ = {};
+      }
+
+      template <class Adapter>
+      void set_adapter(Adapter adapter)
+         { adapter_.emplace(std::move(adapter)); }
+
+      [[nodiscard]] auto get_adapter() noexcept -> auto&
+         { return adapter_; }
+
+      [[nodiscard]] auto get_adapter() const noexcept -> auto const&
+         { return adapter_; }
+
+      // Proceeds with the result of the request.
+      void complete(boost::system::error_code ec)
       {
-         timer_.expires_at(std::chrono::steady_clock::time_point::max());
+         ec_ = ec;
+         proceed();
       }
 
-      auto proceed()
+      [[nodiscard]] auto get_error() const noexcept
+         { return ec_; }
+
+      void proceed()
       {
-         timer_.cancel();
          action_ = action::proceed;
+         notify();
       }
 
       void stop()
       {
-         timer_.cancel();
          action_ = action::stop;
+         notify();
       }
 
       [[nodiscard]] auto is_written() const noexcept
@@ -231,12 +359,18 @@ private:
       [[nodiscard]] auto is_staged() const noexcept
          { return status_ == status::staged; }
 
+      [[nodiscard]] auto is_queued() const noexcept
+         { return status_ == status::queued; }
+
       void mark_written() noexcept
          { status_ = status::written; }
 
       void mark_staged() noexcept
          { status_ = status::staged; }
 
+      void mark_queued() noexcept
+         { status_ = status::queued; }
+
       void reset_status() noexcept
          { status_ = status::none; }
 
@@ -246,75 +380,210 @@ private:
       [[nodiscard]] auto get_request() const noexcept -> auto const&
          { return *req_; }
 
+      // Not null if the request was passed as a shared pointer.
+      [[nodiscard]] auto get_owner() const noexcept -> auto const&
+         { return owner_; }
+
+      void reset_owner() noexcept
+         { owner_.reset(); }
+
       [[nodiscard]] auto get_action() const noexcept
          { return action_;}
 
-      template <class CompletionToken>
-      auto async_wait(CompletionToken token)
+      // Stores the handler until the next call to proceed() or stop(),
+      // or until cancellation is requested through its slot. Calls
+      // made while no handler is stored have no effect.
+      template <class Handler>
+      void async_wait(Handler handler)
       {
-         return timer_.async_wait(std::move(token));
+         BOOST_ASSERT(complete_ == nullptr);
+
+         auto slot = boost::asio::get_associated_cancellation_slot(handler);
+         if (slot.is_connected())
+            slot.template emplace<cancellation_handler>(this);
+
+         if constexpr (is_stored_in_place<Handler>()) {
+            handler_ = new (&storage_) Handler(std::move(handler));
+         } else {
+            using traits = handler_alloc_traits<Handler>;
+            typename traits::allocator_type alloc{boost::asio::get_associated_allocator(handler)};
+            auto* p = traits::allocate(alloc, 1);
+            traits::construct(alloc, p, std::move(handler));
+            handler_ = p;
+         }
+
+         complete_ = &complete_handler<Handler>;
       }
 
+      // Intrusive list of free records, see acquire_request_info.
+      req_info* next_free_ = nullptr;
+
    private:
       enum class status
       { none
+      , queued
       , staged
       , written
       };
 
-      timer_type timer_;
-      action action_;
-      resp3::request const* req_;
-      std::size_t cmds_;
-      status status_;
+      struct cancellation_handler {
+         explicit cancellation_handler(req_info* info) : info_{info} {}
+         void operator()(boost::asio::cancellation_type_t) const { info_->notify_cancelled(); }
+         req_info* info_;
+      };
+
+      template <class Handler>
+      using handler_alloc_traits =
+         typename std::allocator_traits<boost::asio::associated_allocator_t<Handler>>
+            ::template rebind_traits<Handler>;
+
+      // Large enough for an exec_op handler with the usual completion
+      // tokens, larger ones are allocated.
+      static constexpr std::size_t storage_size = 256;
+
+      template <class Handler>
+      static constexpr auto is_stored_in_place() noexcept
+      {
+         return sizeof(Handler) <= storage_size
+             && alignof(Handler) <= alignof(std::max_align_t);
+      }
+
+      // Moves the handler out of the record and posts it, or only
+      // destroys it. The cancellation handler refers to the record,
+      // which may be reused by another operation before the slot is
+      // emitted again, so it is removed unless it is the one running.
+      template <class Handler>
+      static void complete_handler(req_info& info, bool post, bool clear_slot)
+      {
+         auto* p = static_cast<Handler*>(info.handler_);
+         if (clear_slot) {
+            auto slot = boost::asio::get_associated_cancellation_slot(*p);
+            if (slot.is_connected())
+               slot.clear();
+         }
+
+         Handler handler{std::move(*p)};
+
+         if constexpr (is_stored_in_place<Handler>()) {
+            p->~Handler();
+         } else {
+            using traits = handler_alloc_traits<Handler>;
+            typename traits::allocator_type alloc{boost::asio::get_associated_allocator(handler)};
+            traits::destroy(alloc, p);
+            traits::deallocate(alloc, p, 1);
+         }
+
+         info.handler_ = nullptr;
+         info.complete_ = nullptr;
+
+         if (post)
+            boost::asio::post(info.ex_, std::move(handler));
+      }
+
+      void notify()
+      {
+         if (complete_ != nullptr)
+            complete_(*this, true, true);
+      }
+
+      // The slot is cleared when the operation resumes.
+      void notify_cancelled()
+      {
+         if (complete_ != nullptr)
+            complete_(*this, true, false);
+      }
+
+      executor_type ex_;
+      action action_ = action::none;
+      resp3::request const* req_ = nullptr;
+      std::shared_ptr<resp3::request const> owner_;
+      std::size_t cmds_ = 0;
+      status status_ = status::none;
+      detail::request_adapter adapter_;
+      boost::system::error_code ec_;
+
+      void* handler_ = nullptr;
+      void (*complete_)(req_info&, bool, bool) = nullptr;
+      alignas(std::max_align_t) unsigned char storage_[storage_size];
    };
 
-   void remove_request(std::shared_ptr<req_info> const& info)
+   // Returns a record from the pool. It must be released with
+   // release_request_info when the exec_op completes.
+   auto acquire_request_info(resp3::request const& req, std::shared_ptr<resp3::request const> owner) -> req_info*
+   {
+      if (free_reqs_ == nullptr) {
+         req_pool_.emplace_back(get_executor());
+         free_reqs_ = &req_pool_.back();
+      }
+
+      auto* info = free_reqs_;
+      free_reqs_ = info->next_free_;
+      info->reset(req, std::move(owner));
+      return info;
+   }
+
+   void release_request_info(req_info* info)
+   {
+      // Shared requests and the adapter are released as soon as they
+      // complete.
+      info->reset_owner();
+      info->get_adapter().reset();
+      info->next_free_ = free_reqs_;
+      free_reqs_ = info;
+   }
+
+   // Links info before pos, a null pos being the end of the queue.
+   // The segment of pos is the one info is added to, see
+   // first_unstaged_.
+   void insert_request(req_info* pos, req_info* info)
+   {
+      reqs_.insert(pos, info);
+      for (auto** first : {&first_staged_, &first_queued_, &first_unstaged_}) {
+         if (*first == pos)
+            *first = info;
+      }
+   }
+
+   // Does nothing if info is not in the queue anymore.
+   void remove_request(req_info* info)
    {
-      reqs_.erase(std::remove(std::begin(reqs_), std::end(reqs_), info));
+      if (!info->is_linked())
+         return;
+
+      for (auto** first : {&first_staged_, &first_queued_, &first_unstaged_}) {
+         if (*first == info)
+            *first = reqs_.next(info);
+      }
+
+      reqs_.erase(info);
    }
 
-   using reqs_type = std::pmr::deque<std::shared_ptr<req_info>>;
+   using reqs_type = intrusive_list<req_info>;
 
    template <class, class> friend struct detail::receive_op;
    template <class> friend struct detail::reader_op;
    template <class> friend struct detail::writer_op;
    template <class> friend struct detail::run_op;
    template <class, class> friend struct detail::exec_op;
-   template <class, class> friend struct detail::exec_read_op;
    template <class> friend struct detail::send_receive_op;
 
-   void cancel_push_requests()
-   {
-      auto point = std::stable_partition(std::begin(reqs_), std::end(reqs_), [](auto const& ptr) {
-         return !(ptr->is_staged() && ptr->get_request().size() == 0);
-      });
-
-      std::for_each(point, std::end(reqs_), [](auto const& ptr) {
-         ptr->proceed();
-      });
-
-      reqs_.erase(point, std::end(reqs_));
-   }
-
-   void add_request_info(std::shared_ptr<req_info> const& info)
+   void add_request_info(req_info* info)
    {
-      reqs_.push_back(info);
-
-      if (info->get_request().has_hello_priority()) {
-         auto rend = std::partition_point(std::rbegin(reqs_), std::rend(reqs_), [](auto const& e) {
-               return !e->is_written() && !e->is_staged();
-         });
+      if (cfg_.adaptive_write_delay)
+         update_arrival_interval();
 
-         std::rotate(std::rbegin(reqs_), std::rbegin(reqs_) + 1, rend);
-      }
+      // HELLO goes before the requests that haven't been staged.
+      if (info->get_request().has_hello_priority())
+         insert_request(first_unstaged_, info);
+      else
+         insert_request(nullptr, info);
 
-      if (derived().is_open() && cmds_ == 0 && write_buffer_.empty())
-         writer_timer_.cancel();
+      if (derived().is_open())
+         notify_writer();
    }
 
-   auto make_dynamic_buffer(std::size_t max_read_size = 512)
-      { return boost::asio::dynamic_buffer(read_buffer_, max_read_size); }
+   auto make_dynamic_buffer(std::size_t max_read_size = (std::numeric_limits<std::size_t>::max)())
+      { return resp3::dynamic_buffer(read_buffer_, max_read_size); }
 
    template <class CompletionToken>
    auto reader(CompletionToken&& token)
@@ -334,49 +603,202 @@ private:
          >(detail::writer_op<Derived>{&derived()}, token, writer_timer_);
    }
 
-   template <class Adapter, class CompletionToken>
-   auto async_exec_read(Adapter adapter, std::size_t cmds, CompletionToken token)
+   // True while the batch is being written.
+   [[nodiscard]] auto has_pending_write() const noexcept
+      { return !write_batch_.empty(); }
+
+   // True if the next request can be added to the next batch. New
+   // requests are written while responses to previous ones are
+   // pending, up to config::max_in_flight commands, unless they or the
+   // last request before them are not coalesced.
+   [[nodiscard]] auto can_stage() const noexcept
    {
-      return boost::asio::async_compose
-         < CompletionToken
-         , void(boost::system::error_code, std::size_t)
-         >(detail::exec_read_op<Derived, Adapter>{&derived(), adapter, cmds}, token, writer_timer_);
+      if (is_batch_full())
+         return false;
+
+      auto const* next = first_unstaged_;
+      if (next == nullptr)
+         return false;
+
+      if (cmds_ == 0)
+         return true;
+
+      if (!next->get_request().get_config().coalesce)
+         return false;
+
+      auto const* prev = reqs_.prev(next);
+      if (prev != nullptr && !prev->get_request().get_config().coalesce)
+         return false;
+
+      return cmds_ < cfg_.max_in_flight;
    }
 
-   void stage_request(req_info& ri)
+   // True if the writer should write the next batch.
+   [[nodiscard]] auto can_write() const noexcept
    {
-      write_buffer_ += ri.get_request().payload();
+      if (has_pending_write())
+         return false;
+
+      return !next_batch_.empty() || can_stage();
+   }
+
+   // The payload is not copied but written from the request, see
+   // resp3::detail::write_batch, shared requests are kept alive until
+   // the write completes.
+   void queue_request(req_info& ri)
+   {
+      BOOST_ASSERT(&ri == first_unstaged_);
+      first_unstaged_ = reqs_.next(&ri);
+
+      next_batch_.add(ri.get_request());
+      if (ri.get_owner() != nullptr)
+         next_owners_.push_back(ri.get_owner());
+
       cmds_ += ri.get_request().size();
-      ri.mark_staged();
+      ri.mark_queued();
    }
 
    void coalesce_requests()
    {
-      // Coalesce the requests and marks them staged. After a
-      // successful write staged requests will be marked as written.
-      BOOST_ASSERT(write_buffer_.empty());
-      BOOST_ASSERT(!reqs_.empty());
+      // Coalesce the requests into the next batch and marks them
+      // queued. They are marked staged when the batch starts being
+      // written and written after it was.
+      BOOST_ASSERT(first_unstaged_ != nullptr);
 
-      stage_request(*reqs_.at(0));
+      queue_request(*first_unstaged_);
 
-      for (std::size_t i = 1; i < std::size(reqs_); ++i) {
-         if (!reqs_.at(i - 1)->get_request().get_config().coalesce ||
-             !reqs_.at(i - 0)->get_request().get_config().coalesce) {
+      while (first_unstaged_ != nullptr) {
+         if (is_batch_full() ||
+             !reqs_.prev(first_unstaged_)->get_request().get_config().coalesce ||
+             !first_unstaged_->get_request().get_config().coalesce) {
             break;
          }
-         stage_request(*reqs_.at(i));
+         queue_request(*first_unstaged_);
       }
    }
 
+   // Serializes new requests into the next batch, also while the
+   // current one is being written, so it can be written as soon as
+   // the current write completes. Wakes up the writer if it is idle.
+   void notify_writer()
+   {
+      if (can_stage())
+         coalesce_requests();
+
+      if (can_write())
+         writer_timer_.cancel();
+
+      if (is_batch_full())
+         cork_timer_.cancel();
+   }
+
+   [[nodiscard]] auto is_batch_full() const noexcept
+   {
+      return next_batch_.size() >= cfg_.max_batch_bytes
+          || next_batch_.commands() >= cfg_.max_batch_commands;
+   }
+
+   // Exponentially weighted moving average of the time between
+   // requests, seeded with the first interval measured.
+   void update_arrival_interval()
+   {
+      auto const now = clock_type::now();
+      if (arrival_interval_)
+         *arrival_interval_ += ((now - *last_arrival_) - *arrival_interval_) / 8;
+      else if (last_arrival_)
+         arrival_interval_ = now - *last_arrival_;
+
+      last_arrival_ = now;
+   }
+
+   // How long the writer waits for more requests before writing the
+   // next batch, see config::max_write_delay.
+   [[nodiscard]] auto get_write_delay() const noexcept -> clock_type::duration
+   {
+      if (is_batch_full())
+         return clock_type::duration::zero();
+
+      // No request can be added after one that is not coalesced.
+      auto const* prev = reqs_.prev(first_unstaged_);
+      if (prev != nullptr && !prev->get_request().get_config().coalesce)
+         return clock_type::duration::zero();
+
+      if (!cfg_.adaptive_write_delay)
+         return cfg_.max_write_delay;
+
+      if (!arrival_interval_)
+         return cfg_.max_write_delay;
+
+      if (*arrival_interval_ >= cfg_.max_write_delay)
+         return clock_type::duration::zero();
+
+      return cfg_.max_write_delay - *arrival_interval_;
+   }
+
+   // Makes the next batch the current one.
+   void stage_requests()
+   {
+      BOOST_ASSERT(!has_pending_write());
+
+      if (can_stage())
+         coalesce_requests();
+
+      write_batch_.swap(next_batch_);
+      write_owners_.swap(next_owners_);
+
+      BOOST_ASSERT(first_staged_ == first_queued_);
+      for (auto* info = first_queued_; info != first_unstaged_; info = reqs_.next(info))
+         info->mark_staged();
+
+      first_queued_ = first_unstaged_;
+   }
+
+   // Drops the batches of a previous connection, queued requests are
+   // staged again on the next one.
+   void clear_batches()
+   {
+      write_batch_.clear();
+      next_batch_.clear();
+      write_owners_.clear();
+      next_owners_.clear();
+      cmds_ = 0;
+
+      for (auto* info = first_queued_; info != first_unstaged_; info = reqs_.next(info))
+         info->reset_status();
+
+      first_unstaged_ = first_queued_;
+   }
+
+   config cfg_;
+
    // IO objects
    timer_type writer_timer_;
-   timer_type read_timer_;
+   timer_type cork_timer_;
    push_channel_type push_channel_;
 
-   std::pmr::string read_buffer_;
-   std::pmr::string write_buffer_;
+   resp3::read_buffer read_buffer_;
+   resp3::detail::write_batch write_batch_;
+   resp3::detail::write_batch next_batch_;
+   std::pmr::vector<std::shared_ptr<resp3::request const>> write_owners_;
+   std::pmr::vector<std::shared_ptr<resp3::request const>> next_owners_;
    std::size_t cmds_ = 0;
    reqs_type reqs_;
+
+   // The queue is split in segments of written, staged, queued and
+   // unstaged requests, in this order. These point to the first
+   // request of the last three, null if the segment and the ones
+   // after it are empty.
+   req_info* first_staged_ = nullptr;
+   req_info* first_queued_ = nullptr;
+   req_info* first_unstaged_ = nullptr;
+
+   std::pmr::deque<req_info> req_pool_;
+   req_info* free_reqs_ = nullptr;
+
+   // Used when config::adaptive_write_delay is set, empty until the
+   // first request and the first interval are seen.
+   std::optional<clock_type::time_point> last_arrival_;
+   std::optional<clock_type::duration> arrival_interval_;
 };
 
 } // aedis
@@ -7,12 +7,18 @@
 #ifndef AEDIS_CONNECTION_OPS_HPP
 #define AEDIS_CONNECTION_OPS_HPP
 
+#include <new>
 #include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <algorithm>
+#include <type_traits>
 
 #include <boost/assert.hpp>
 #include <boost/system.hpp>
 #include <boost/asio/write.hpp>
+#include <boost/asio/ip/tcp.hpp>
 #include <boost/core/ignore_unused.hpp>
 #include <boost/asio/experimental/parallel_group.hpp>
 
@@ -21,6 +27,7 @@
 #include <aedis/detail/net.hpp>
 #include <aedis/resp3/type.hpp>
 #include <aedis/resp3/detail/parser.hpp>
+#include <aedis/resp3/detail/read_ops.hpp>
 #include <aedis/resp3/read.hpp>
 #include <aedis/resp3/write.hpp>
 #include <aedis/resp3/request.hpp>
@@ -69,74 +76,372 @@ struct receive_op {
    }
 };
 
-template <class Conn, class Adapter>
-struct exec_read_op {
-   Conn* conn;
+// Forwards the nodes of the response at position i of a request to
+// the adapter.
+//
+// When a response is split in several commands, see
+// resp3::request::config::max_range_size, only the first part passes
+// its top-level aggregate header on, with the size of the merged
+// aggregate, top-level numbers are merged and passed on with the
+// last part and of other top-level values only the last one and
+// errors are passed on. The parts share the state of the adapter.
+template <class Adapter>
+struct indexed_adapter {
    Adapter adapter;
-   std::size_t cmds = 0;
-   std::size_t read_size = 0;
-   std::size_t index = 0;
-   boost::asio::coroutine coro{};
+   std::size_t i = 0;
+   bool merge = false;
+   bool first = true;
+   bool last = true;
+   resp3::detail::merge numbers = resp3::detail::merge::sum;
+   std::int64_t number = 0;
+   std::size_t elements = 0;
+   char buffer[resp3::detail::max_integer_size] = {};
+
+   [[nodiscard]]
+   auto get_skip_mode() const noexcept
+      { return detail::get_skip_mode(adapter, i); }
+
+   void operator()(resp3::node<boost::string_view> const& nd, boost::system::error_code& ec)
+   {
+      if (merge && nd.depth == 0) {
+         if (nd.data_type == resp3::type::number) {
+            auto const v = resp3::detail::parse_int(nd.value.data(), nd.value.size(), ec);
+            auto merged = nd;
+            if (ec || !merge_number(merged, v))
+               return;
 
-   template <class Self>
-   void
-   operator()( Self& self
-             , boost::system::error_code ec = {}
-             , std::size_t n = 0)
+            return adapter(i, merged, ec);
+         }
+
+         if (resp3::is_aggregate(nd.data_type)) {
+            if (!first)
+               return;
+
+            auto merged = nd;
+            merged.aggregate_size = elements;
+            return adapter(i, merged, ec);
+         }
+
+         if (!last && !is_error(nd.data_type))
+            return;
+      }
+
+      adapter(i, nd, ec);
+   }
+
+   template <
+      class Value,
+      class A = Adapter,
+      class = decltype(std::declval<A&>()(std::size_t{}, std::declval<resp3::node<boost::string_view> const&>(), std::declval<Value>(), std::declval<boost::system::error_code&>()))>
+   void operator()(resp3::node<boost::string_view> const& nd, Value v, boost::system::error_code& ec)
    {
-      reenter (coro)
-      {
-         // Loop reading the responses to this request.
-         BOOST_ASSERT(!conn->reqs_.empty());
-         while (cmds != 0) {
-            BOOST_ASSERT(conn->cmds_ != 0);
-
-            //-----------------------------------
-            // If we detect a push in the middle of a request we have
-            // to hand it to the push consumer. To do that we need
-            // some data in the read bufer.
-            if (conn->read_buffer_.empty()) {
-               yield
-               boost::asio::async_read_until(
-                  conn->next_layer(),
-                  conn->make_dynamic_buffer(),
-                  "\r\n", std::move(self));
-               AEDIS_CHECK_OP1(conn->cancel(operation::run));
-            }
+      if constexpr (std::is_same<Value, std::int64_t>::value) {
+         if (merge && nd.depth == 0 && nd.data_type == resp3::type::number) {
+            auto merged = nd;
+            if (merge_number(merged, v))
+               adapter(i, merged, number, ec);
+            return;
+         }
+      }
 
-            // If the next request is a push we have to handle it to
-            // the receive_op wait for it to be done and continue.
-            if (resp3::to_type(conn->read_buffer_.front()) == resp3::type::push) {
-               yield
-               async_send_receive(conn->push_channel_, std::move(self));
-               AEDIS_CHECK_OP1(conn->cancel(operation::run));
-               continue;
-            }
-            //-----------------------------------
+      if (merge && nd.depth == 0 && !last)
+         return;
 
-            yield
-            resp3::async_read(
-               conn->next_layer(),
-               conn->make_dynamic_buffer(adapter.get_max_read_size(index)),
-                  [i = index, adpt = adapter] (resp3::node<boost::string_view> const& nd, boost::system::error_code& ec) mutable { adpt(i, nd, ec); },
-                  std::move(self));
+      adapter(i, nd, v, ec);
+   }
 
-            ++index;
+   template <
+      class A = Adapter,
+      class = decltype(std::declval<A&>().get_bulk_storage(std::size_t{}, std::declval<resp3::node<boost::string_view> const&>(), std::size_t{}, std::declval<boost::system::error_code&>()))>
+   auto get_bulk_storage(resp3::node<boost::string_view> const& nd, std::size_t size, boost::system::error_code& ec) -> char*
+      { return adapter.get_bulk_storage(i, nd, size, ec); }
 
-            AEDIS_CHECK_OP1(conn->cancel(operation::run));
+   template <
+      class A = Adapter,
+      class = decltype(std::declval<A&>().begin_bulk_chunks(std::size_t{}, std::declval<resp3::node<boost::string_view> const&>(), std::size_t{}, std::declval<boost::system::error_code&>()))>
+   auto begin_bulk_chunks(resp3::node<boost::string_view> const& nd, std::size_t size, boost::system::error_code& ec) -> bool
+      { return adapter.begin_bulk_chunks(i, nd, size, ec); }
 
-            read_size += n;
+   void on_bulk_chunk(resp3::node<boost::string_view> const& nd, std::size_t remaining, boost::system::error_code& ec)
+      { adapter.on_bulk_chunk(i, nd, remaining, ec); }
 
-            BOOST_ASSERT(cmds != 0);
-            --cmds;
+   static auto is_error(resp3::type t) noexcept
+      { return t == resp3::type::simple_error || t == resp3::type::blob_error; }
 
-            BOOST_ASSERT(conn->cmds_ != 0);
-            --conn->cmds_;
+   // Returns true if the merged number has to be passed on, in
+   // which case the node contains its text.
+   auto merge_number(resp3::node<boost::string_view>& nd, std::int64_t v) -> bool
+   {
+      using resp3::detail::merge;
+
+      if (first) {
+         number = v;
+      } else {
+         switch (numbers) {
+            case merge::sum: number += v; break;
+            case merge::max: number = (std::max)(number, v); break;
          }
+      }
 
-         self.complete({}, read_size);
+      if (!last)
+         return false;
+
+      nd.value = {buffer, resp3::detail::integer_to_chars(buffer, number)};
+      return true;
+   }
+};
+
+class request_adapter;
+
+struct any_adapter_vtable {
+   resp3::detail::skip_mode (*get_skip_mode)(void const*) noexcept;
+   void (*on_node)(void*, resp3::node<boost::string_view> const&, boost::system::error_code&);
+   void (*on_int)(void*, resp3::node<boost::string_view> const&, std::int64_t, boost::system::error_code&);
+   void (*on_double)(void*, resp3::node<boost::string_view> const&, double, boost::system::error_code&);
+   void (*on_bool)(void*, resp3::node<boost::string_view> const&, bool, boost::system::error_code&);
+   char* (*get_bulk_storage)(void*, resp3::node<boost::string_view> const&, std::size_t, boost::system::error_code&);
+   bool (*begin_bulk_chunks)(void*, resp3::node<boost::string_view> const&, std::size_t, boost::system::error_code&);
+   void (*on_bulk_chunk)(void*, resp3::node<boost::string_view> const&, std::size_t, boost::system::error_code&);
+};
+
+// The type-erased indexed_adapter of the current command of a
+// request_adapter, it is what the parser calls.
+class any_adapter {
+public:
+   [[nodiscard]]
+   auto get_skip_mode() const noexcept
+      { return vtable_->get_skip_mode(obj_); }
+
+   void operator()(resp3::node<boost::string_view> const& nd, boost::system::error_code& ec)
+      { vtable_->on_node(obj_, nd, ec); }
+
+   void operator()(resp3::node<boost::string_view> const& nd, std::int64_t v, boost::system::error_code& ec)
+      { vtable_->on_int(obj_, nd, v, ec); }
+
+   void operator()(resp3::node<boost::string_view> const& nd, double v, boost::system::error_code& ec)
+      { vtable_->on_double(obj_, nd, v, ec); }
+
+   void operator()(resp3::node<boost::string_view> const& nd, bool v, boost::system::error_code& ec)
+      { vtable_->on_bool(obj_, nd, v, ec); }
+
+   // Null if the adapter has no storage for bulks.
+   auto get_bulk_storage(resp3::node<boost::string_view> const& nd, std::size_t size, boost::system::error_code& ec) -> char*
+      { return vtable_->get_bulk_storage(obj_, nd, size, ec); }
+
+   // False if the adapter doesn't consume bulks in chunks.
+   auto begin_bulk_chunks(resp3::node<boost::string_view> const& nd, std::size_t size, boost::system::error_code& ec) -> bool
+      { return vtable_->begin_bulk_chunks(obj_, nd, size, ec); }
+
+   void on_bulk_chunk(resp3::node<boost::string_view> const& nd, std::size_t remaining, boost::system::error_code& ec)
+      { vtable_->on_bulk_chunk(obj_, nd, remaining, ec); }
+
+private:
+   friend class request_adapter;
+
+   any_adapter(any_adapter_vtable const* vt, void* obj) noexcept
+   : vtable_{vt}, obj_{obj} {}
+
+   any_adapter_vtable const* vtable_;
+   void* obj_;
+};
+
+// The adapter of a request, stored in its completion record so the
+// reader can parse the responses to any request, see
+// connection_base::req_info. The responses are parsed one command at
+// a time into the adapter returned by next().
+class request_adapter {
+public:
+   request_adapter() = default;
+   request_adapter(request_adapter const&) = delete;
+   auto operator=(request_adapter const&) -> request_adapter& = delete;
+   ~request_adapter() { reset(); }
+
+   template <class Adapter>
+   void emplace(Adapter adapter)
+   {
+      BOOST_ASSERT(obj_ == nullptr);
+
+      if constexpr (is_stored_in_place<model<Adapter>>())
+         obj_ = new (&storage_) model<Adapter>{std::move(adapter), {}};
+      else
+         obj_ = new model<Adapter>{std::move(adapter), {}};
+
+      vtable_ = &model<Adapter>::table;
+      started_ = false;
+      index_ = 0;
+      merged_ = 0;
+      number_ = 0;
+      read_size_ = 0;
+   }
+
+   // Destroys the adapter.
+   void reset() noexcept
+   {
+      if (obj_ != nullptr) {
+         vtable_->destroy(obj_);
+         obj_ = nullptr;
+      }
+   }
+
+   // Maps the next command to its response, see
+   // resp3::request::merged.
+   auto next(resp3::request const& req) -> any_adapter
+   {
+      auto const& cmds = req.merged();
+
+      bool const first = !(merged_ < cmds.size() && cmds[merged_].index == index_);
+      auto numbers = resp3::detail::merge::sum;
+      if (!first) {
+         numbers = cmds[merged_].numbers;
+         ++merged_;
+      }
+
+      bool const last = !(merged_ < cmds.size() && cmds[merged_].index == index_ + 1);
+      std::size_t elements = 0;
+      if (!last) {
+         numbers = cmds[merged_].numbers;
+         elements = cmds[merged_].elements;
       }
+
+      started_ = true;
+      vtable_->start(obj_, index_ - merged_, first, last, numbers, number_, elements);
+      return {vtable_->current, obj_};
    }
+
+   // Called when the response to the command returned by next() has
+   // been parsed.
+   void commit() noexcept
+   {
+      number_ = vtable_->get_number(obj_);
+      ++index_;
+   }
+
+   // True once next() has been called, the adapter may have been
+   // passed part of the response since.
+   [[nodiscard]] auto is_started() const noexcept
+      { return started_; }
+
+   // The number of commands whose response has been parsed.
+   [[nodiscard]] auto get_parsed_commands() const noexcept
+      { return index_; }
+
+   [[nodiscard]] auto get_max_read_size() const noexcept
+      { return vtable_->get_max_read_size(obj_, index_ - merged_); }
+
+   [[nodiscard]] auto get_read_size() const noexcept
+      { return read_size_; }
+
+   void add_read_size(std::size_t n) noexcept
+      { read_size_ += n; }
+
+private:
+   struct vtable {
+      void (*start)(void*, std::size_t, bool, bool, resp3::detail::merge, std::int64_t, std::size_t);
+      std::int64_t (*get_number)(void const*);
+      std::size_t (*get_max_read_size)(void const*, std::size_t);
+      void (*destroy)(void*) noexcept;
+      any_adapter_vtable const* current;
+   };
+
+   // The adapter and the indexed_adapter of the current command.
+   template <class Adapter>
+   struct model {
+      Adapter adapter;
+      std::optional<indexed_adapter<Adapter>> current;
+
+      static auto self(void* p) -> model& { return *static_cast<model*>(p); }
+      static auto self(void const* p) -> model const& { return *static_cast<model const*>(p); }
+
+      static void start(void* p, std::size_t i, bool first, bool last, resp3::detail::merge numbers, std::int64_t number, std::size_t elements)
+      {
+         // The parts of a split command continue with the adapter
+         // of the first one.
+         auto& m = self(p);
+         if (first)
+            m.current.emplace(indexed_adapter<Adapter>{m.adapter});
+
+         m.current->i = i;
+         m.current->first = first;
+         m.current->last = last;
+         m.current->merge = !first || !last;
+         m.current->numbers = numbers;
+         m.current->number = number;
+         m.current->elements = elements;
+      }
+
+      static auto get_number(void const* p) -> std::int64_t
+         { return self(p).current->number; }
+
+      static auto get_max_read_size(void const* p, std::size_t i) -> std::size_t
+         { return self(p).adapter.get_max_read_size(i); }
+
+      static void destroy(void* p) noexcept
+      {
+         if constexpr (is_stored_in_place<model>())
+            self(p).~model();
+         else
+            delete &self(p);
+      }
+
+      template <class Value>
+      static void on_value(void* p, resp3::node<boost::string_view> const& nd, Value v, boost::system::error_code& ec)
+         { resp3::detail::call_adapter(*self(p).current, nd, v, ec); }
+
+      static void on_node(void* p, resp3::node<boost::string_view> const& nd, boost::system::error_code& ec)
+         { (*self(p).current)(nd, ec); }
+
+      static auto get_skip_mode(void const* p) noexcept
+         { return self(p).current->get_skip_mode(); }
+
+      static auto get_bulk_storage(void* p, resp3::node<boost::string_view> const& nd, std::size_t size, boost::system::error_code& ec) -> char*
+      {
+         if constexpr (resp3::detail::has_bulk_storage<indexed_adapter<Adapter>>::value)
+            return self(p).current->get_bulk_storage(nd, size, ec);
+         else
+            return nullptr;
+      }
+
+      static auto begin_bulk_chunks(void* p, resp3::node<boost::string_view> const& nd, std::size_t size, boost::system::error_code& ec) -> bool
+      {
+         if constexpr (resp3::detail::has_bulk_sink<indexed_adapter<Adapter>>::value)
+            return self(p).current->begin_bulk_chunks(nd, size, ec);
+         else
+            return false;
+      }
+
+      static void on_bulk_chunk(void* p, resp3::node<boost::string_view> const& nd, std::size_t remaining, boost::system::error_code& ec)
+      {
+         if constexpr (resp3::detail::has_bulk_sink<indexed_adapter<Adapter>>::value)
+            self(p).current->on_bulk_chunk(nd, remaining, ec);
+      }
+
+      static constexpr any_adapter_vtable current_table
+         { &get_skip_mode, &on_node, &on_value<std::int64_t>, &on_value<double>, &on_value<bool>
+         , &get_bulk_storage, &begin_bulk_chunks, &on_bulk_chunk};
+
+      static constexpr vtable table
+         {&start, &get_number, &get_max_read_size, &destroy, &current_table};
+   };
+
+   // Large enough for the adapters of adapt(), larger ones are
+   // allocated.
+   static constexpr std::size_t storage_size = 256;
+
+   template <class Model>
+   static constexpr auto is_stored_in_place() noexcept
+   {
+      return sizeof(Model) <= storage_size
+          && alignof(Model) <= alignof(std::max_align_t);
+   }
+
+   vtable const* vtable_ = nullptr;
+   void* obj_ = nullptr;
+   bool started_ = false;
+   std::size_t index_ = 0;
+   std::size_t merged_ = 0;
+   std::int64_t number_ = 0;
+   std::size_t read_size_ = 0;
+   alignas(std::max_align_t) unsigned char storage_[storage_size];
 };
 
 template <class Conn, class Adapter>
@@ -146,15 +451,20 @@ struct exec_op {
    Conn* conn = nullptr;
    resp3::request const* req = nullptr;
    Adapter adapter{};
-   std::shared_ptr<req_info_type> info = nullptr;
-   std::size_t read_size = 0;
+   std::shared_ptr<resp3::request const> owner = nullptr;
+   req_info_type* info = nullptr;
    boost::asio::coroutine coro{};
 
+   // Returns the record to the connection's pool before completing.
    template <class Self>
-   void
-   operator()( Self& self
-             , boost::system::error_code ec = {}
-             , std::size_t n = 0)
+   void release_and_complete(Self& self, boost::system::error_code ec, std::size_t n)
+   {
+      conn->release_request_info(info);
+      self.complete(ec, n);
+   }
+
+   template <class Self>
+   void operator()(Self& self)
    {
       reenter (coro)
       {
@@ -168,71 +478,64 @@ struct exec_op {
             return self.complete(error::not_connected, 0);
          }
 
-         info = std::allocate_shared<req_info_type>(boost::asio::get_associated_allocator(self), *req, conn->get_executor());
+         // There is nothing to write nor to read, the batch can't
+         // carry the request.
+         if (req->payload().empty()) {
+            yield boost::asio::post(std::move(self));
+            return self.complete({}, 0);
+         }
+
+         info = conn->acquire_request_info(*req, std::move(owner));
+         info->set_adapter(std::move(adapter));
 
          conn->add_request_info(info);
 EXEC_OP_WAIT:
          yield info->async_wait(std::move(self));
-         BOOST_ASSERT(ec == boost::asio::error::operation_aborted);
 
          if (info->get_action() == Conn::req_info::action::stop) {
             // Don't have to call remove_request as it has already
             // been by cancel(exec).
-            return self.complete(ec, 0);
+            return release_and_complete(self, boost::asio::error::operation_aborted, 0);
          }
 
-         if (is_cancelled(self)) {
-            if (info->is_written()) {
-               self.get_cancellation_state().clear();
-               goto EXEC_OP_WAIT; // Too late, can't cancel.
-            } else {
-               conn->remove_request(info);
-               self.complete(ec, 0);
-               return;
-            }
+         if (info->get_action() == Conn::req_info::action::proceed) {
+            // The reader has removed the request after parsing its
+            // response, or after failing to, see reader_op.
+            // Requests without response are done once written.
+            return release_and_complete(self, info->get_error(), info->get_adapter().get_read_size());
          }
 
-         BOOST_ASSERT(conn->is_open());
-          
-         if (req->size() == 0) {
-            // Don't have to call remove_request as it has already
-            // been removed.
-            return self.complete({}, 0);
+         BOOST_ASSERT(is_cancelled(self));
+         if (info->is_written() || info->is_staged() || info->is_queued()) {
+            self.get_cancellation_state().clear();
+            goto EXEC_OP_WAIT; // Too late, can't cancel.
          }
 
-         BOOST_ASSERT(!conn->reqs_.empty());
-         BOOST_ASSERT(conn->reqs_.front() != nullptr);
-         BOOST_ASSERT(conn->cmds_ != 0);
-         yield
-         conn->async_exec_read(adapter, conn->reqs_.front()->get_number_of_commands(), std::move(self));
-         if (is_cancelled(self)) {
-            conn->remove_request(info);
-            return self.complete(boost::asio::error::operation_aborted, {});
-         }
-
-         if (ec) {
-            return self.complete(ec, {});
-         }
-
-         read_size = n;
-
-         BOOST_ASSERT(!conn->reqs_.empty());
-         conn->reqs_.pop_front();
-
-         if (conn->cmds_ == 0) {
-            conn->read_timer_.cancel_one();
-            if (!conn->reqs_.empty())
-               conn->writer_timer_.cancel_one();
-         } else {
-            BOOST_ASSERT(!conn->reqs_.empty());
-            conn->reqs_.front()->proceed();
-         }
-
-         self.complete({}, read_size);
+         conn->remove_request(info);
+         release_and_complete(self, boost::asio::error::operation_aborted, 0);
       }
    }
 };
 
+template <class Stream, class = void>
+struct is_tcp_stream : std::false_type {};
+
+template <class Stream>
+struct is_tcp_stream<Stream, std::enable_if_t<
+   std::is_same<typename Stream::lowest_layer_type::protocol_type, boost::asio::ip::tcp>::value
+   >> : std::true_type {};
+
+// Requests written while earlier ones are unacknowledged would
+// otherwise be delayed by Nagle's algorithm.
+template <class Stream>
+void set_no_delay(Stream& stream)
+{
+   if constexpr (is_tcp_stream<Stream>::value) {
+      boost::system::error_code ignore;
+      stream.lowest_layer().set_option(boost::asio::ip::tcp::no_delay{true}, ignore);
+   }
+}
+
 template <class Conn>
 struct run_op {
    Conn* conn = nullptr;
@@ -246,8 +549,8 @@ struct run_op {
    {
       reenter (coro)
       {
-         conn->write_buffer_.clear();
-         conn->cmds_ = 0;
+         conn->clear_batches();
+         set_no_delay(conn->next_layer());
 
          yield
          boost::asio::experimental::make_parallel_group(
@@ -285,10 +588,23 @@ struct writer_op {
 
       reenter (coro) for (;;)
       {
-         while (!conn->reqs_.empty() && conn->cmds_ == 0 && conn->write_buffer_.empty()) {
-            conn->coalesce_requests();
+         while (conn->can_write()) {
+            if (conn->can_stage())
+               conn->coalesce_requests();
+
+            // Waits for more requests, see config::max_write_delay.
+            if (conn->get_write_delay().count() != 0) {
+               conn->cork_timer_.expires_after(conn->get_write_delay());
+               yield conn->cork_timer_.async_wait(std::move(self));
+               if (!conn->is_open() || is_cancelled(self)) {
+                  self.complete({});
+                  return;
+               }
+            }
+
+            conn->stage_requests();
             yield
-            boost::asio::async_write(conn->next_layer(), boost::asio::buffer(conn->write_buffer_), std::move(self));
+            resp3::detail::async_write_batch(conn->next_layer(), conn->write_batch_, std::move(self));
             AEDIS_CHECK_OP0(conn->cancel(operation::run));
 
             conn->on_write();
@@ -316,30 +632,63 @@ struct writer_op {
 
 template <class Conn>
 struct reader_op {
+   using parser_type = resp3::detail::parser<any_adapter>;
+   using req_info_type = typename Conn::req_info;
+
    Conn* conn;
+   req_info_type* info = nullptr;
+   std::optional<parser_type> parser{};
    boost::asio::coroutine coro{};
 
+   // The error goes to the request whose response was being read,
+   // if any. If the connection has been closed in the meantime it
+   // has been dealt with by cancel_on_conn_lost already.
+   template <class Self>
+   void stop(Self& self, boost::system::error_code ec)
+   {
+      if (!ec)
+         ec = boost::asio::error::operation_aborted;
+
+      if (info != nullptr && conn->is_open()) {
+         conn->remove_request(info);
+         info->complete(ec);
+         ec = boost::asio::error::operation_aborted;
+      }
+
+      conn->cancel(operation::run);
+      self.complete(ec);
+   }
+
    template <class Self>
    void operator()( Self& self
                   , boost::system::error_code ec = {}
                   , std::size_t n = 0)
    {
-      boost::ignore_unused(n);
-
       reenter (coro) for (;;)
       {
-         yield
-         boost::asio::async_read_until(
-            conn->next_layer(),
-            conn->make_dynamic_buffer(),
-            "\r\n", std::move(self));
+         // Data that has been read past the last response is already
+         // in the buffer and doesn't require another read.
+         if (conn->read_buffer_.empty()) {
+            // The read is for the response to the request in front of
+            // the queue if it has been written already.
+            info = conn->reqs_.front();
+            if (info != nullptr && !info->is_written())
+               info = nullptr;
 
-         if (ec == boost::asio::error::eof) {
-            conn->cancel(operation::run);
-            return self.complete({}); // EOFINAE: EOF is not an error.
-         }
+            yield
+            resp3::detail::async_read_at_least(
+               conn->next_layer(),
+               conn->make_dynamic_buffer(),
+               1, std::move(self));
 
-         AEDIS_CHECK_OP0(conn->cancel(operation::run));
+            if (ec == boost::asio::error::eof && info == nullptr) {
+               conn->cancel(operation::run);
+               return self.complete({}); // EOFINAE: EOF is not an error.
+            }
+
+            if (ec || is_cancelled(self))
+               return stop(self, ec);
+         }
 
          // We handle unsolicited events in the following way
          //
@@ -359,6 +708,7 @@ struct reader_op {
          //    wrong syntax.
          //
          BOOST_ASSERT(!conn->read_buffer_.empty());
+         info = nullptr;
          if (resp3::to_type(conn->read_buffer_.front()) == resp3::type::push
              || conn->reqs_.empty()
              || (!conn->reqs_.empty() && conn->reqs_.front()->get_number_of_commands() == 0)) {
@@ -368,19 +718,69 @@ struct reader_op {
                self.complete(boost::asio::error::basic_errors::operation_aborted);
                return;
             }
-         } else {
-            BOOST_ASSERT(conn->cmds_ != 0);
-            BOOST_ASSERT(!conn->reqs_.empty());
-            BOOST_ASSERT(conn->reqs_.front()->get_number_of_commands() != 0);
-            conn->reqs_.front()->proceed();
-            yield conn->read_timer_.async_wait(std::move(self));
-            if (!conn->is_open() || is_cancelled(self)) {
-               // Added this cancel here to make sure any outstanding
-               // ping is cancelled.
-               conn->cancel(operation::run);
-               self.complete(boost::asio::error::basic_errors::operation_aborted);
-               return;
+            continue;
+         }
+
+         // Parses the response to the next command of the request in
+         // front of the queue into its adapter, reading only when the
+         // response is incomplete.
+         info = conn->reqs_.front();
+         BOOST_ASSERT(conn->cmds_ != 0);
+         BOOST_ASSERT(info->get_number_of_commands() != 0);
+
+         parser.emplace(info->get_adapter().next(info->get_request()));
+         for (;;) {
+            n = resp3::detail::consume_available(*parser, conn->read_buffer_.data(), conn->read_buffer_.size(), ec);
+            conn->make_dynamic_buffer().consume(n);
+            info->get_adapter().add_read_size(n);
+            if (ec)
+               return stop(self, ec);
+
+            if (parser->done())
+               break;
+
+            if (resp3::detail::direct_buffer(*parser, conn->read_buffer_.size()).size() != 0) {
+               yield
+               boost::asio::async_read(
+                  conn->next_layer(),
+                  resp3::detail::direct_buffer(*parser, conn->read_buffer_.size()),
+                  std::move(self));
+
+               // A socket.close() may have been called while a
+               // successful read might had already been queued.
+               if (ec || is_cancelled(self) || !conn->is_open())
+                  return stop(self, ec);
+
+               parser->commit_bulk(n);
+               info->get_adapter().add_read_size(n);
+               continue;
             }
+
+            yield
+            resp3::detail::async_read_at_least(
+               conn->next_layer(),
+               conn->make_dynamic_buffer(info->get_adapter().get_max_read_size()),
+               resp3::detail::missing_size(*parser, conn->read_buffer_.size()),
+               std::move(self));
+            if (ec || is_cancelled(self) || !conn->is_open())
+               return stop(self, ec);
+         }
+
+         info->get_adapter().commit();
+
+         BOOST_ASSERT(conn->cmds_ != 0);
+         --conn->cmds_;
+
+         // Completes the exec_op without waiting for it, the
+         // responses that are already in the buffer are parsed in the
+         // same call.
+         if (info->get_adapter().get_parsed_commands() == info->get_number_of_commands()) {
+            conn->remove_request(info);
+            info->complete({});
+
+            // The writer may be waiting for responses to be read, see
+            // config::max_in_flight.
+            conn->notify_writer();
          }
       }
    }
@@ -0,0 +1,133 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_DETAIL_INTRUSIVE_LIST_HPP
+#define AEDIS_DETAIL_INTRUSIVE_LIST_HPP
+
+#include <cstddef>
+
+#include <boost/assert.hpp>
+
+namespace aedis::detail {
+
+template <class T>
+class intrusive_list;
+
+// Base class of the elements of an intrusive_list, an element can be
+// in at most one list at a time.
+template <class T>
+class intrusive_list_hook {
+public:
+   [[nodiscard]] auto is_linked() const noexcept
+      { return linked_; }
+
+private:
+   friend class intrusive_list<T>;
+
+   T* prev_ = nullptr;
+   T* next_ = nullptr;
+   bool linked_ = false;
+};
+
+// A doubly linked list of elements it does not own. Elements are
+// referred to by pointer, the null pointer being the end of the
+// list. All operations are O(1).
+template <class T>
+class intrusive_list {
+public:
+   intrusive_list() = default;
+   intrusive_list(intrusive_list const&) = delete;
+   auto operator=(intrusive_list const&) -> intrusive_list& = delete;
+
+   [[nodiscard]] auto empty() const noexcept
+      { return head_ == nullptr; }
+
+   [[nodiscard]] auto size() const noexcept
+      { return size_; }
+
+   [[nodiscard]] auto front() const noexcept -> T*
+      { return head_; }
+
+   [[nodiscard]] auto back() const noexcept -> T*
+      { return tail_; }
+
+   // The element after x, null if x is the last one.
+   [[nodiscard]] static auto next(T const* x) noexcept -> T*
+      { return hook(x)->next_; }
+
+   // The element before x, the last one if x is the end.
+   [[nodiscard]] auto prev(T const* x) const noexcept -> T*
+      { return x == nullptr ? tail_ : hook(x)->prev_; }
+
+   void push_back(T* x) noexcept
+      { insert(nullptr, x); }
+
+   // Inserts x before pos.
+   void insert(T* pos, T* x) noexcept
+   {
+      BOOST_ASSERT(!hook(x)->linked_);
+
+      auto* const prev = this->prev(pos);
+      hook(x)->prev_ = prev;
+      hook(x)->next_ = pos;
+      hook(x)->linked_ = true;
+
+      if (prev == nullptr)
+         head_ = x;
+      else
+         hook(prev)->next_ = x;
+
+      if (pos == nullptr)
+         tail_ = x;
+      else
+         hook(pos)->prev_ = x;
+
+      ++size_;
+   }
+
+   // Removes x from the list and returns the element that followed it.
+   auto erase(T* x) noexcept -> T*
+   {
+      BOOST_ASSERT(hook(x)->linked_);
+
+      auto* const prev = hook(x)->prev_;
+      auto* const next = hook(x)->next_;
+
+      if (prev == nullptr)
+         head_ = next;
+      else
+         hook(prev)->next_ = next;
+
+      if (next == nullptr)
+         tail_ = prev;
+      else
+         hook(next)->prev_ = prev;
+
+      hook(x)->prev_ = nullptr;
+      hook(x)->next_ = nullptr;
+      hook(x)->linked_ = false;
+      --size_;
+      return next;
+   }
+
+   void pop_front() noexcept
+      { erase(head_); }
+
+private:
+   static auto hook(T* x) noexcept -> intrusive_list_hook<T>*
+      { return x; }
+
+   static auto hook(T const* x) noexcept -> intrusive_list_hook<T> const*
+      { return x; }
+
+   T* head_ = nullptr;
+   T* tail_ = nullptr;
+   std::size_t size_ = 0;
+};
+
+} // aedis::detail
+
+#endif // AEDIS_DETAIL_INTRUSIVE_LIST_HPP
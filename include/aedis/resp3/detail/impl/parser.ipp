@@ -4,22 +4,274 @@
  * accompanying file LICENSE.txt)
  */
 
-#include <boost/spirit/include/qi.hpp>
-#include <boost/spirit/home/x3.hpp>
+#include <limits>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <charconv>
+#include <algorithm>
+
+#include <boost/endian/conversion.hpp>
 
 #include <aedis/resp3/detail/parser.hpp>
 #include <aedis/resp3/type.hpp>
 
 namespace aedis::resp3::detail {
 
+namespace {
+
+auto to_digit(char c) noexcept -> unsigned
+{
+   // Characters below '0' wrap around and are rejected as well.
+   return static_cast<unsigned char>(c - '0');
+}
+
+// Loads eight characters so that the first one is in the least
+// significant byte.
+auto load_eight(char const* p) noexcept -> std::uint64_t
+{
+   std::uint64_t v = 0;
+   std::memcpy(&v, p, sizeof v);
+   return boost::endian::little_to_native(v);
+}
+
+// SWAR check that the eight bytes in v are all in '0'..'9'.
+auto is_eight_digits(std::uint64_t v) noexcept -> bool
+{
+   return ((v & 0xF0F0F0F0F0F0F0F0) | (((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+}
+
+// SWAR conversion of eight digits, see
+// https://lemire.me/blog/2022/01/21/swar-explained-parsing-eight-digits
+auto parse_eight_digits(std::uint64_t v) noexcept -> std::uint64_t
+{
+   std::uint64_t constexpr mask = 0x000000FF000000FF;
+   std::uint64_t constexpr mul1 = 0x000F424000000064; // 100 + (1000000 << 32)
+   std::uint64_t constexpr mul2 = 0x0000271000000001; // 1 + (10000 << 32)
+   v -= 0x3030303030303030;
+   v = (v * 10) + (v >> 8);
+   return (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+}
+
+// Decodes the digits in [p, end) into ret. Returns false if there
+// are no digits, a non-digit or if the result doesn't fit in 64
+// bits.
+auto parse_digits(char const* p, char const* end, std::uint64_t& ret) noexcept -> bool
+{
+   // Up to 19 digits can't overflow.
+   std::ptrdiff_t constexpr safe_digits = 19;
+
+   if (p == end)
+      return false;
+
+   auto const* const safe_end = p + (std::min)(end - p, safe_digits);
+
+   std::uint64_t v = 0;
+   while (safe_end - p >= 8) {
+      auto const w = load_eight(p);
+      if (!is_eight_digits(w))
+         return false;
+
+      v = v * 100000000 + parse_eight_digits(w);
+      p += 8;
+   }
+
+   for (; p != safe_end; ++p) {
+      auto const d = to_digit(*p);
+      if (d > 9)
+         return false;
+
+      v = v * 10 + d;
+   }
+
+   if (p != end) {
+      auto const d = to_digit(*p);
+      if (end - p > 1 || d > 9 || v > ((std::numeric_limits<std::uint64_t>::max)() - d) / 10)
+         return false;
+
+      v = v * 10 + d;
+   }
+
+   ret = v;
+   return true;
+}
+
+// Case insensitive comparison with a lower case literal.
+auto iequals(char const* p, char const* end, char const* lower) noexcept -> bool
+{
+   auto const n = std::strlen(lower);
+   if (static_cast<std::size_t>(end - p) != n)
+      return false;
+
+   for (std::size_t i = 0; i < n; ++i) {
+      if ((p[i] | 0x20) != lower[i])
+         return false;
+   }
+
+   return true;
+}
+
+// Used when the fast path can't round correctly. Expects a string
+// that has already been validated and has no sign.
+auto parse_double_slow(char const* p, char const* end, boost::system::error_code& ec) -> double
+{
+   double ret = 0;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+   auto const res = std::from_chars(p, end, ret);
+   if (res.ec != std::errc{} || res.ptr != end)
+      ec = error::not_a_double;
+#else
+   // NOTE: strtod depends on the decimal point of the current locale.
+   std::string const str{p, end};
+   char* str_end = nullptr;
+   ret = std::strtod(str.c_str(), &str_end);
+   if (str_end != str.c_str() + str.size())
+      ec = error::not_a_double;
+#endif
+   return ret;
+}
+
+} // anonymous
+
 auto parse_uint(char const* data, std::size_t size, boost::system::error_code& ec) -> std::size_t
 {
-   static constexpr boost::spirit::x3::uint_parser<std::size_t, 10> p{};
-   std::size_t ret = 0;
-   if (!parse(data, data + size, p, ret))
+   std::uint64_t ret = 0;
+   if (!parse_digits(data, data + size, ret) || ret > (std::numeric_limits<std::size_t>::max)()) {
       ec = error::not_a_number;
+      return 0;
+   }
 
-   return ret;
+   return static_cast<std::size_t>(ret);
+}
+
+auto parse_int(char const* data, std::size_t size, boost::system::error_code& ec) -> std::int64_t
+{
+   auto constexpr max = static_cast<std::uint64_t>((std::numeric_limits<std::int64_t>::max)());
+
+   bool const neg = size != 0 && *data == '-';
+
+   std::uint64_t m = 0;
+   if (!parse_digits(data + (neg ? 1 : 0), data + size, m) || m > max + (neg ? 1 : 0)) {
+      ec = error::not_a_number;
+      return 0;
+   }
+
+   if (!neg)
+      return static_cast<std::int64_t>(m);
+
+   if (m == max + 1)
+      return (std::numeric_limits<std::int64_t>::min)();
+
+   return -static_cast<std::int64_t>(m);
+}
+
+// Validates the input and, if the decimal significand and the
+// exponent are small enough for the result to be exact, computes it
+// with a single multiplication or division (Clinger's fast path, as
+// used in fast_float). Everything else goes through from_chars.
+auto parse_double(char const* data, std::size_t size, boost::system::error_code& ec) -> double
+{
+   static constexpr double pow10[] =
+   { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11
+   , 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+   auto const* p = data;
+   auto const* const end = data + size;
+
+   bool const neg = p != end && *p == '-';
+   if (p != end && (*p == '-' || *p == '+'))
+      ++p;
+
+   auto const* const start = p;
+
+   if (p != end && to_digit(*p) > 9 && *p != '.') {
+      if (iequals(p, end, "inf") || iequals(p, end, "infinity"))
+         return neg ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+
+      if (iequals(p, end, "nan"))
+         return std::numeric_limits<double>::quiet_NaN();
+
+      ec = error::not_a_double;
+      return 0;
+   }
+
+   // At most 19 significant digits are accumulated, the remaining
+   // ones only adjust the exponent.
+   std::uint64_t mantissa = 0;
+   int digits = 0;
+   std::int64_t exp10 = 0;
+   bool truncated = false;
+   bool has_digits = false;
+
+   for (; p != end && to_digit(*p) <= 9; ++p) {
+      has_digits = true;
+      auto const d = to_digit(*p);
+      if (digits < 19) {
+         mantissa = mantissa * 10 + d;
+         digits += mantissa != 0;
+      } else {
+         ++exp10;
+         truncated = truncated || d != 0;
+      }
+   }
+
+   if (p != end && *p == '.') {
+      for (++p; p != end && to_digit(*p) <= 9; ++p) {
+         has_digits = true;
+         auto const d = to_digit(*p);
+         if (digits < 19) {
+            mantissa = mantissa * 10 + d;
+            digits += mantissa != 0;
+            --exp10;
+         } else {
+            truncated = truncated || d != 0;
+         }
+      }
+   }
+
+   if (!has_digits) {
+      ec = error::not_a_double;
+      return 0;
+   }
+
+   if (p != end && (*p == 'e' || *p == 'E')) {
+      ++p;
+      bool const eneg = p != end && *p == '-';
+      if (p != end && (*p == '-' || *p == '+'))
+         ++p;
+
+      if (p == end) {
+         ec = error::not_a_double;
+         return 0;
+      }
+
+      std::int64_t e = 0;
+      for (; p != end && to_digit(*p) <= 9; ++p) {
+         if (e < 100000)
+            e = e * 10 + to_digit(*p);
+      }
+
+      exp10 += eneg ? -e : e;
+   }
+
+   if (p != end) {
+      ec = error::not_a_double;
+      return 0;
+   }
+
+   double ret = 0;
+   if (mantissa == 0) {
+      ret = 0;
+   } else if (!truncated && mantissa <= (std::uint64_t{1} << 53) && exp10 >= -22 && exp10 <= 22) {
+      ret = static_cast<double>(mantissa);
+      ret = exp10 < 0 ? ret / pow10[-exp10] : ret * pow10[exp10];
+   } else {
+      ret = parse_double_slow(start, end, ec);
+      if (ec)
+         return 0;
+   }
+
+   return neg ? -ret : ret;
 }
 
 } // aedis::resp3::detail
@@ -8,8 +8,13 @@
 #define AEDIS_RESP3_PARSER_HPP
 
 #include <array>
+#include <algorithm>
 #include <limits>
+#include <cstdint>
+#include <cstring>
+#include <utility>
 #include <system_error>
+#include <type_traits>
 
 #include <boost/assert.hpp>
 #include <boost/utility/string_view.hpp>
@@ -19,7 +24,123 @@
 
 namespace aedis::resp3::detail {
 
+// Decimal decoders for lengths, integers and doubles. The input must
+// be the complete field, e.g. without the CRLF, otherwise ec is set.
 auto parse_uint(char const* data, std::size_t size, boost::system::error_code& ec) -> std::size_t;
+auto parse_int(char const* data, std::size_t size, boost::system::error_code& ec) -> std::int64_t;
+auto parse_double(char const* data, std::size_t size, boost::system::error_code& ec) -> double;
+
+/* Adapters opt into typed scalar events by providing the overloads
+ *
+ *    void operator()(node<boost::string_view> const&, std::int64_t, boost::system::error_code&);
+ *    void operator()(node<boost::string_view> const&, double, boost::system::error_code&);
+ *    void operator()(node<boost::string_view> const&, bool, boost::system::error_code&);
+ *
+ * which the parser calls for numbers, doubles and booleans with the
+ * value decoded once during framing. The node still contains the raw
+ * text. Values that can't be decoded are delivered as text only.
+ */
+template <class Adapter, class = void>
+struct accepts_typed_scalars : std::false_type {};
+
+template <class Adapter>
+struct accepts_typed_scalars<Adapter, std::void_t<
+   decltype(std::declval<Adapter&>()(std::declval<node<boost::string_view> const&>(), std::int64_t{}, std::declval<boost::system::error_code&>())),
+   decltype(std::declval<Adapter&>()(std::declval<node<boost::string_view> const&>(), double{}, std::declval<boost::system::error_code&>())),
+   decltype(std::declval<Adapter&>()(std::declval<node<boost::string_view> const&>(), bool{}, std::declval<boost::system::error_code&>()))
+   >> : std::true_type {};
+
+// Calls the typed overload if the adapter has one, otherwise the
+// text-only one.
+template <class Adapter, class Value>
+void
+call_adapter(
+   Adapter& adapter,
+   node<boost::string_view> const& nd,
+   Value v,
+   boost::system::error_code& ec)
+{
+   if constexpr (accepts_typed_scalars<Adapter>::value)
+      adapter(nd, v, ec);
+   else
+      adapter(nd, ec);
+}
+
+// How the parser treats a response whose content is not needed.
+enum class skip_mode
+{ none          // Nodes are passed to the adapter.
+, discard       // Only framed, errors are ignored as well.
+, check_errors  // Only framed, a top-level error sets ec.
+};
+
+/* Adapters that don't need the response report it with
+ *
+ *    skip_mode get_skip_mode() const noexcept;
+ *
+ * in which case the parser only tracks aggregate sizes and bulk
+ * lengths and never calls the adapter.
+ */
+template <class Adapter, class = void>
+struct has_skip_mode : std::false_type {};
+
+template <class Adapter>
+struct has_skip_mode<Adapter, std::void_t<
+   decltype(std::declval<Adapter const&>().get_skip_mode())
+   >> : std::true_type {};
+
+template <class Adapter>
+auto get_skip_mode(Adapter const& adapter) noexcept -> skip_mode
+{
+   if constexpr (has_skip_mode<Adapter>::value)
+      return adapter.get_skip_mode();
+   else
+      return skip_mode::none;
+}
+
+/* Adapters that can store bulk strings in their final destination
+ * provide
+ *
+ *    char* get_bulk_storage(node<boost::string_view> const& nd, std::size_t size, boost::system::error_code& ec);
+ *
+ * where nd has an empty value and size is the length of the payload.
+ * A non-null return points to size bytes and takes the place of the
+ * adapter call for that node: the parser writes the payload there as
+ * it arrives and the read operations read what has not arrived yet
+ * directly from the stream into it. Returning null falls back to
+ * the normal path.
+ */
+template <class Adapter, class = void>
+struct has_bulk_storage : std::false_type {};
+
+template <class Adapter>
+struct has_bulk_storage<Adapter, std::void_t<
+   decltype(std::declval<Adapter&>().get_bulk_storage(
+      std::declval<node<boost::string_view> const&>(),
+      std::size_t{},
+      std::declval<boost::system::error_code&>()))
+   >> : std::true_type {};
+
+/* Adapters that consume bulk strings as a stream provide
+ *
+ *    bool begin_bulk_chunks(node<boost::string_view> const& nd, std::size_t size, boost::system::error_code& ec);
+ *    void on_bulk_chunk(node<boost::string_view> const& nd, std::size_t remaining, boost::system::error_code& ec);
+ *
+ * If begin_bulk_chunks returns true the payload is passed to
+ * on_bulk_chunk in pieces as it arrives instead of in a single node,
+ * where nd.value is the piece and remaining the number of payload
+ * bytes that follow it. Memory usage is then bounded by the size of
+ * a read instead of the size of the bulk.
+ */
+template <class Adapter, class = void>
+struct has_bulk_sink : std::false_type {};
+
+template <class Adapter>
+struct has_bulk_sink<Adapter, std::void_t<
+   decltype(std::declval<Adapter&>().begin_bulk_chunks(
+      std::declval<node<boost::string_view> const&>(),
+      std::size_t{},
+      std::declval<boost::system::error_code&>()))
+   >> : std::true_type {};
 
 template <class ResponseAdapter>
 class parser {
@@ -46,9 +167,172 @@ private:
    // expected.
    type bulk_ = type::invalid;
 
+   skip_mode skip_;
+
+   // Where the payload of the current bulk is stored if the adapter
+   // provided the storage.
+   char* bulk_dest_ = nullptr;
+
+   // True if the payload of the current bulk is passed to the
+   // adapter in chunks.
+   bool bulk_chunked_ = false;
+
+   // Bulks that are consumed in parts only: The number of bytes of
+   // the current bulk (including the CRLF) that have already been
+   // consumed.
+   std::size_t bulk_offset_ = 0;
+
+   // Smaller bulks are cheaper to copy from the read buffer.
+   static constexpr std::size_t min_partial_bulk = 4096;
+
+   // Offers the bulk that has just been announced to the adapter's
+   // sink or storage.
+   void on_bulk(type t, boost::system::error_code& ec)
+   {
+      bulk_ = t;
+      if (t == type::blob_error || bulk_length_ < min_partial_bulk)
+         return;
+
+      if constexpr (has_bulk_sink<ResponseAdapter>::value) {
+         bulk_chunked_ = adapter_.begin_bulk_chunks({t, 1, depth_, {}}, bulk_length_, ec);
+         if (ec || bulk_chunked_)
+            return;
+      }
+
+      if constexpr (has_bulk_storage<ResponseAdapter>::value)
+         bulk_dest_ = adapter_.get_bulk_storage({t, 1, depth_, {}}, bulk_length_, ec);
+   }
+
+   void on_number(type t, boost::string_view v, boost::system::error_code& ec)
+   {
+      if constexpr (accepts_typed_scalars<ResponseAdapter>::value) {
+         boost::system::error_code dec;
+         switch (t) {
+            case type::number:
+            {
+               auto const i = parse_int(v.data(), v.size(), dec);
+               if (!dec)
+                  return adapter_({t, 1, depth_, v}, i, ec);
+            } break;
+            case type::doublean:
+            {
+               auto const d = parse_double(v.data(), v.size(), dec);
+               if (!dec)
+                  return adapter_({t, 1, depth_, v}, d, ec);
+            } break;
+            default: break;
+         }
+      }
+
+      adapter_({t, 1, depth_, v}, ec);
+   }
+
+   void pop() noexcept
+   {
+      while (sizes_[depth_] == 0) {
+         --depth_;
+         --sizes_[depth_];
+      }
+   }
+
+   // Skip mode version of consume for lines. Nothing is passed to the
+   // adapter and, except for a top-level error, the content of simple
+   // types is not checked.
+   auto
+   skip_line(char const* data, std::size_t n, boost::system::error_code& ec) -> std::size_t
+   {
+      auto const t = to_type(*data);
+      switch (t) {
+         case type::streamed_string_part:
+         {
+            auto const l = parse_uint(data + 1, n - 3, ec);
+            if (ec)
+               return 0;
+
+            if (l == 0) {
+               sizes_[depth_] = 0;
+            } else {
+               bulk_length_ = l;
+               bulk_ = t;
+               return n;
+            }
+         } break;
+         case type::blob_error:
+         case type::verbatim_string:
+         case type::blob_string:
+         {
+            if (depth_ == 0 && t == type::blob_error && skip_ == skip_mode::check_errors) {
+               ec = error::resp3_blob_error;
+               return 0;
+            }
+
+            if (n > 1 && data[1] == '?') {
+               sizes_[++depth_] = (std::numeric_limits<std::size_t>::max)();
+               return n;
+            }
+
+            bulk_length_ = parse_uint(data + 1, n - 3, ec);
+            if (ec)
+               return 0;
+
+            bulk_ = t;
+            return n;
+         }
+         case type::simple_error:
+         {
+            if (depth_ == 0 && skip_ == skip_mode::check_errors) {
+               ec = error::resp3_simple_error;
+               return 0;
+            }
+
+            --sizes_[depth_];
+         } break;
+         case type::boolean:
+         case type::doublean:
+         case type::big_number:
+         case type::number:
+         case type::simple_string:
+         case type::null:
+         {
+            --sizes_[depth_];
+         } break;
+         case type::push:
+         case type::set:
+         case type::array:
+         case type::attribute:
+         case type::map:
+         {
+            auto const l = parse_uint(data + 1, n - 3, ec);
+            if (ec)
+               return 0;
+
+            if (l == 0) {
+               --sizes_[depth_];
+            } else {
+               if (depth_ == max_embedded_depth) {
+                  ec = error::exceeeds_max_nested_depth;
+                  return 0;
+               }
+
+               ++depth_;
+               sizes_[depth_] = l * element_multiplicity(t);
+            }
+         } break;
+         default:
+         {
+            ec = error::invalid_data_type;
+            return 0;
+         }
+      }
+
+      pop();
+      return n;
+   }
+
 public:
    explicit parser(ResponseAdapter adapter)
    : adapter_{adapter}
+   , skip_{get_skip_mode(adapter_)}
    {
       sizes_[0] = 2; // The sentinel must be more than 1.
    }
@@ -57,7 +341,9 @@ public:
    auto
    consume(char const* data, std::size_t n, boost::system::error_code& ec) -> std::size_t
    {
-      if (bulk_ != type::invalid) {
+      if (bulk_ != type::invalid && partial()) {
+         return consume_part(data, n, ec);
+      } else if (bulk_ != type::invalid) {
          n = bulk_length_ + 2;
          switch (bulk_) {
             case type::streamed_string_part:
@@ -78,12 +364,14 @@ public:
          bulk_ = type::invalid;
          --sizes_[depth_];
 
+      } else if (skip_ != skip_mode::none) {
+         return skip_line(data, n, ec);
       } else if (sizes_[depth_] != 0) {
          auto const t = to_type(*data);
          switch (t) {
             case type::streamed_string_part:
             {
-               bulk_length_ = parse_uint(data + 1, n - 2, ec);
+               bulk_length_ = parse_uint(data + 1, n - 3, ec);
 	       if (ec)
 		  return 0;
 
@@ -91,7 +379,9 @@ public:
                   adapter_({type::streamed_string_part, 1, depth_, {}}, ec);
                   sizes_[depth_] = 0; // We are done.
                } else {
-                  bulk_ = type::streamed_string_part;
+                  on_bulk(type::streamed_string_part, ec);
+                  if (ec)
+                     return 0;
                }
             } break;
             case type::blob_error:
@@ -106,11 +396,13 @@ public:
 		  // 0.
                   sizes_[++depth_] = (std::numeric_limits<std::size_t>::max)();
                } else {
-                  bulk_length_ = parse_uint(data + 1, n - 2, ec);
+                  bulk_length_ = parse_uint(data + 1, n - 3, ec);
                   if (ec)
                      return 0;
 
-                  bulk_ = t;
+                  on_bulk(t, ec);
+                  if (ec)
+                     return 0;
                }
             } break;
             case type::boolean:
@@ -125,7 +417,7 @@ public:
                    return 0;
                }
 
-               adapter_({t, 1, depth_, {data + 1, n - 3}}, ec);
+               call_adapter(adapter_, {t, 1, depth_, {data + 1, n - 3}}, data[1] == 't', ec);
 	       if (ec)
 		  return 0;
 
@@ -140,7 +432,7 @@ public:
                    return 0;
                }
 
-               adapter_({t, 1, depth_, {data + 1, n - 3}}, ec);
+               on_number(t, {data + 1, n - 3}, ec);
 	       if (ec)
 		  return 0;
 
@@ -169,7 +461,7 @@ public:
             case type::attribute:
             case type::map:
             {
-	       auto const l = parse_uint(data + 1, n - 2, ec);
+	       auto const l = parse_uint(data + 1, n - 3, ec);
                if (ec)
                   return 0;
 
@@ -197,18 +489,85 @@ public:
             }
          }
       }
-      
-      while (sizes_[depth_] == 0) {
-         --depth_;
+
+      pop();
+      return n;
+   }
+
+   // Consumes up to n bytes of a bulk that doesn't have to be
+   // complete, see partial(). Stored bulks are copied into the
+   // adapter's storage, chunked ones passed to the adapter and
+   // skipped ones discarded. Returns the number of bytes consumed.
+   auto
+   consume_part(char const* data, std::size_t n, boost::system::error_code& ec) -> std::size_t
+   {
+      BOOST_ASSERT(partial());
+
+      auto const total = bulk_length_ + 2;
+      n = (std::min)(n, total - bulk_offset_);
+
+      auto const payload = bulk_offset_ < bulk_length_ ? (std::min)(n, bulk_length_ - bulk_offset_) : 0;
+      if (bulk_dest_ != nullptr) {
+         std::memcpy(bulk_dest_ + bulk_offset_, data, payload);
+      } else if (bulk_chunked_ && payload != 0) {
+         if constexpr (has_bulk_sink<ResponseAdapter>::value) {
+            adapter_.on_bulk_chunk({bulk_, 1, depth_, {data, payload}}, bulk_length_ - bulk_offset_ - payload, ec);
+            if (ec)
+               return 0;
+         }
+      }
+
+      bulk_offset_ += n;
+      if (bulk_offset_ == total) {
+         bulk_ = type::invalid;
+         bulk_dest_ = nullptr;
+         bulk_chunked_ = false;
+         bulk_offset_ = 0;
          --sizes_[depth_];
+         pop();
       }
-      
+
       return n;
    }
 
+   // Stored bulks only: The part of the adapter's storage the payload
+   // that has not been consumed yet goes to. Empty if there is none.
+   [[nodiscard]] auto bulk_storage() const noexcept -> std::pair<char*, std::size_t>
+   {
+      if (bulk_dest_ == nullptr || bulk_offset_ >= bulk_length_)
+         return {nullptr, 0};
+
+      return {bulk_dest_ + bulk_offset_, bulk_length_ - bulk_offset_};
+   }
+
+   // Stored bulks only: Accounts for n bytes that have been written
+   // directly into bulk_storage().
+   void commit_bulk(std::size_t n) noexcept
+   {
+      BOOST_ASSERT(n <= bulk_storage().second);
+      bulk_offset_ += n;
+   }
+
+   // The number of bytes of the current bulk (including the CRLF)
+   // that have not been consumed yet.
+   [[nodiscard]] auto bulk_remaining() const noexcept
+      { return bulk_length_ + 2 - bulk_offset_; }
+
+   // Returns true if the current bulk can be consumed in parts, i.e.
+   // it is skipped, chunked or stored in the adapter's storage.
+   [[nodiscard]] auto partial() const noexcept
+      { return skipping() || bulk_chunked_ || bulk_dest_ != nullptr; }
+
+   // Returns true if the response is only being framed.
+   [[nodiscard]] auto skipping() const noexcept
+      { return skip_ != skip_mode::none; }
+
    // Returns true when the parser is done with the current message.
+   // The sentinel is decremented only when the top-level element has
+   // been completely parsed, which makes it possible to distinguish
+   // a finished message from one that has not yet been started.
    [[nodiscard]] auto done() const noexcept
-      { return depth_ == 0 && bulk_ == type::invalid; }
+      { return depth_ == 0 && bulk_ == type::invalid && sizes_[0] == 1; }
 
    // The bulk type expected in the next read. If none is expected returns
    // type::invalid.
@@ -216,6 +575,8 @@ public:
 
    // The length expected in the the next bulk.
    [[nodiscard]] auto bulk_length() const noexcept { return bulk_length_; }
+
+   [[nodiscard]] auto get_adapter() const noexcept -> auto const& { return adapter_; }
 };
 
 } // detail::resp3::aedis
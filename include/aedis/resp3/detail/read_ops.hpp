@@ -7,14 +7,28 @@
 #ifndef AEDIS_RESP3_READ_OPS_HPP
 #define AEDIS_RESP3_READ_OPS_HPP
 
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
 #include <boost/assert.hpp>
 #include <boost/asio/read.hpp>
-#include <boost/asio/read_until.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/compose.hpp>
 #include <boost/asio/coroutine.hpp>
 #include <boost/core/ignore_unused.hpp>
 #include <boost/utility/string_view.hpp>
 #include <aedis/resp3/detail/parser.hpp>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define AEDIS_RESP3_SSE2
+#  include <emmintrin.h>
+#  if defined(_MSC_VER) && !defined(__clang__)
+#     include <intrin.h>
+#  endif
+#endif
+
 #include <boost/asio/yield.hpp>
 
 namespace aedis::detail
@@ -43,6 +57,10 @@ auto is_cancelled(T const& self)
 namespace aedis::resp3::detail {
 
 struct ignore_response {
+   [[nodiscard]]
+   auto get_skip_mode() const noexcept
+      { return skip_mode::check_errors; }
+
    void operator()(node<boost::string_view> nd, boost::system::error_code& ec)
    {
       switch (nd.data_type) {
@@ -53,6 +71,318 @@ struct ignore_response {
    }
 };
 
+// Returns the size of the first line in [data, data + size)
+// including the CRLF or zero if there is no complete line. memchr is
+// vectorized by all major libc implementations, which makes this
+// much cheaper than a byte-by-byte search.
+inline
+auto find_line(char const* data, std::size_t size) noexcept -> std::size_t
+{
+   auto const* const end = data + size;
+   auto const* p = data;
+   for (;;) {
+      p = static_cast<char const*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+      if (p == nullptr)
+         return 0;
+
+      if (p != data && p[-1] == '\r')
+         return static_cast<std::size_t>(p - data) + 1;
+
+      ++p;
+   }
+}
+
+/* Finds the lines in [data, data + size). With SSE2 the positions of
+ * all LF characters in a block of 64 bytes are computed at once into
+ * a bit mask (in the spirit of simdjson's structural index), so that
+ * replies made of many short lines, e.g. large aggregates, cost a few
+ * instructions per line instead of a call to memchr. Otherwise it
+ * falls back to find_line.
+ */
+class line_scanner {
+private:
+   static constexpr std::size_t block_size = 64;
+   static constexpr auto npos = static_cast<std::size_t>(-1);
+
+   char const* data_;
+   std::size_t size_;
+
+   // The block whose mask has been computed.
+   std::size_t block_ = npos;
+   std::uint64_t mask_ = 0;
+
+#ifdef AEDIS_RESP3_SSE2
+   static auto lowest_bit(std::uint64_t m) noexcept -> std::size_t
+   {
+#if defined(_MSC_VER) && !defined(__clang__)
+      unsigned long i = 0;
+      _BitScanForward64(&i, m);
+      return i;
+#else
+      return static_cast<std::size_t>(__builtin_ctzll(m));
+#endif
+   }
+
+   // Returns the mask of LF positions in the block that starts at pos.
+   auto compute_mask(std::size_t pos) const noexcept -> std::uint64_t
+   {
+      auto const* const p = data_ + pos;
+      if (size_ - pos < block_size) {
+         std::uint64_t m = 0;
+         for (std::size_t i = 0; i < size_ - pos; ++i)
+            m |= static_cast<std::uint64_t>(p[i] == '\n') << i;
+         return m;
+      }
+
+      auto const lf = _mm_set1_epi8('\n');
+      auto const m0 = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p)), lf)));
+      auto const m1 = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p + 16)), lf)));
+      auto const m2 = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p + 32)), lf)));
+      auto const m3 = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p + 48)), lf)));
+      return std::uint64_t{m0} | (std::uint64_t{m1} << 16) | (std::uint64_t{m2} << 32) | (std::uint64_t{m3} << 48);
+   }
+#endif
+
+public:
+   line_scanner(char const* data, std::size_t size) noexcept
+   : data_{data}
+   , size_{size}
+   { }
+
+   // Returns the size of the line that starts at pos including the
+   // CRLF or zero if it is not complete.
+   auto line_at(std::size_t pos) noexcept -> std::size_t
+   {
+#ifdef AEDIS_RESP3_SSE2
+      auto block = pos / block_size;
+      auto m = std::uint64_t{0};
+      if (block == block_)
+         m = mask_;
+
+      // Ignores the LFs before pos.
+      m &= ~std::uint64_t{0} << (pos % block_size);
+
+      for (;;) {
+         if (block != block_) {
+            if (block * block_size >= size_)
+               return 0;
+
+            block_ = block;
+            mask_ = compute_mask(block * block_size);
+            m = mask_;
+            if (block * block_size < pos)
+               m &= ~std::uint64_t{0} << (pos % block_size);
+         }
+
+         while (m != 0) {
+            auto const lf = block * block_size + lowest_bit(m);
+            if (lf != pos && data_[lf - 1] == '\r')
+               return lf - pos + 1;
+
+            m &= m - 1;
+         }
+
+         ++block;
+      }
+#else
+      return find_line(data_ + pos, size_ - pos);
+#endif
+   }
+};
+
+// Feeds the parser with all complete lines and bulks that are
+// available in [data, data + size) in a single loop. Stops when the
+// message is complete or when more data is needed and returns the
+// number of bytes consumed.
+template <class ResponseAdapter>
+auto
+consume_available(
+   parser<ResponseAdapter>& p,
+   char const* data,
+   std::size_t size,
+   boost::system::error_code& ec) -> std::size_t
+{
+   line_scanner lines{data, size};
+   std::size_t consumed = 0;
+   while (!p.done()) {
+      std::size_t n = 0;
+      if (p.bulk() == type::invalid) {
+         n = lines.line_at(consumed);
+         if (n == 0)
+            break;
+      } else if (p.partial()) {
+         // Ignored bulks are discarded, chunked ones passed on and
+         // stored ones copied to their destination as they arrive so
+         // that they never have to fit in the buffer.
+         n = p.consume_part(data + consumed, size - consumed, ec);
+         if (ec || n == 0)
+            break;
+
+         consumed += n;
+         continue;
+      } else {
+         n = p.bulk_length() + 2;
+         if (size - consumed < n)
+            break;
+      }
+
+      n = p.consume(data + consumed, n, ec);
+      if (ec)
+         break;
+
+      consumed += n;
+   }
+
+   return consumed;
+}
+
+// The minimum number of bytes the parser needs to make progress. On
+// a bulk read we can't read until the delimiter since the payload
+// may contain the delimiter itself, so we have to read the whole
+// chunk.
+template <class ResponseAdapter>
+auto missing_size(parser<ResponseAdapter> const& p, std::size_t buffer_size) noexcept -> std::size_t
+{
+   // Skipped, chunked and stored bulks are consumed as they arrive,
+   // any amount of data makes progress.
+   if (p.bulk() == type::invalid || p.partial())
+      return 1;
+
+   auto const n = p.bulk_length() + 2;
+   return n > buffer_size ? n - buffer_size : 1;
+}
+
+// Returns the adapter's storage for the rest of the bulk payload if
+// it can be read from the stream directly, which is the case when
+// there is nothing else in the buffer. Otherwise returns an empty
+// buffer.
+template <class ResponseAdapter>
+auto direct_buffer(parser<ResponseAdapter> const& p, std::size_t buffer_size) noexcept -> boost::asio::mutable_buffer
+{
+   if (buffer_size != 0)
+      return {};
+
+   auto const [data, size] = p.bulk_storage();
+   return {data, size};
+}
+
+// Returns how many bytes should be requested from the stream. Like
+// asio::read_until, reads are as large as the free capacity of the
+// buffer (bounded by 64k) so that multiple lines are usually obtained
+// with a single read_some. Returns zero if the buffer can't grow
+// enough.
+template <class DynamicBuffer>
+auto read_size_hint(DynamicBuffer const& buf, std::size_t needed) noexcept -> std::size_t
+{
+   std::size_t constexpr min_size = 512;
+   std::size_t constexpr max_size = 65536;
+
+   auto const size = buf.size();
+   auto const room = buf.max_size() - size;
+   if (room < needed)
+      return 0;
+
+   auto const free = buf.capacity() > size ? buf.capacity() - size : 0;
+   auto const chunk = (std::min)((std::max)(free, min_size), max_size);
+   return (std::max)(needed, (std::min)(chunk, room));
+}
+
+// Grows the buffer and reads at least needed bytes from the stream.
+template <class SyncReadStream, class DynamicBuffer>
+auto
+read_at_least(
+   SyncReadStream& stream,
+   DynamicBuffer& buf,
+   std::size_t needed,
+   boost::system::error_code& ec) -> std::size_t
+{
+   auto const size = buf.size();
+   auto const read_size = read_size_hint(buf, needed);
+   if (read_size == 0) {
+      ec = boost::asio::error::not_found;
+      return 0;
+   }
+
+   buf.grow(read_size);
+   auto const n =
+      boost::asio::read(
+         stream,
+         buf.data(size, read_size),
+         boost::asio::transfer_at_least(needed),
+         ec);
+   buf.shrink(read_size - n);
+   return n;
+}
+
+template <class AsyncReadStream, class DynamicBuffer>
+class read_at_least_op {
+private:
+   AsyncReadStream& stream_;
+   DynamicBuffer buf_;
+   std::size_t needed_;
+   std::size_t buffer_size_ = 0;
+   std::size_t read_size_ = 0;
+   boost::asio::coroutine coro_{};
+
+public:
+   read_at_least_op(AsyncReadStream& stream, DynamicBuffer buf, std::size_t needed)
+   : stream_ {stream}
+   , buf_ {std::move(buf)}
+   , needed_ {needed}
+   { }
+
+   template <class Self>
+   void operator()( Self& self
+                  , boost::system::error_code ec = {}
+                  , std::size_t n = 0)
+   {
+      reenter (coro_)
+      {
+         buffer_size_ = buf_.size();
+         read_size_ = read_size_hint(buf_, needed_);
+         if (read_size_ == 0) {
+            yield boost::asio::post(std::move(self));
+            self.complete(boost::asio::error::not_found, 0);
+            return;
+         }
+
+         buf_.grow(read_size_);
+
+         yield
+         boost::asio::async_read(
+            stream_,
+            buf_.data(buffer_size_, read_size_),
+            boost::asio::transfer_at_least(needed_),
+            std::move(self));
+
+         buf_.shrink(read_size_ - n);
+         AEDIS_CHECK_OP1();
+
+         self.complete({}, n);
+      }
+   }
+};
+
+// Grows the buffer and reads at least needed bytes from the stream.
+template <
+   class AsyncReadStream,
+   class DynamicBuffer,
+   class CompletionToken>
+auto
+async_read_at_least(
+   AsyncReadStream& stream,
+   DynamicBuffer buf,
+   std::size_t needed,
+   CompletionToken&& token)
+{
+   return boost::asio::async_compose
+      < CompletionToken
+      , void(boost::system::error_code, std::size_t)
+      >(read_at_least_op<AsyncReadStream, DynamicBuffer> {stream, buf, needed},
+        token,
+        stream);
+}
+
 template <
    class AsyncReadStream,
    class DynamicBuffer,
@@ -63,7 +393,8 @@ private:
    DynamicBuffer buf_;
    parser<ResponseAdapter> parser_;
    std::size_t consumed_ = 0;
-   std::size_t buffer_size_ = 0;
+   boost::system::error_code ec_;
+   bool has_read_ = false;
    boost::asio::coroutine coro_{};
 
 public:
@@ -79,47 +410,56 @@ public:
                   , std::size_t n = 0)
    {
       reenter (coro_) for (;;) {
-         if (parser_.bulk() == type::invalid) {
-            yield
-            boost::asio::async_read_until(stream_, buf_, "\r\n", std::move(self));
-            AEDIS_CHECK_OP1();
-         } else {
-	    // On a bulk read we can't read until delimiter since the
-	    // payload may contain the delimiter itself so we have to
-	    // read the whole chunk. However if the bulk blob is small
-	    // enough it may be already on the buffer (from the last
-	    // read), in which case there is no need of initiating
-	    // another async op, otherwise we have to read the missing
-	    // bytes.
-            if (buf_.size() < (parser_.bulk_length() + 2)) {
-               buffer_size_ = buf_.size();
-               buf_.grow(parser_.bulk_length() + 2 - buffer_size_);
-
-               yield
-               boost::asio::async_read(
-                  stream_,
-                  buf_.data(buffer_size_, parser_.bulk_length() + 2 - buffer_size_),
-                  boost::asio::transfer_all(),
-                  std::move(self));
-               AEDIS_CHECK_OP1();
+         // Everything that is already in the buffer is parsed before
+         // suspending so that a response that has been received as a
+         // whole costs a single resumption.
+         n = consume_available(
+               parser_,
+               static_cast<char const*>(buf_.data(0, buf_.size()).data()),
+               buf_.size(),
+               ec);
+
+         buf_.consume(n);
+         consumed_ += n;
+
+         if (ec || parser_.done()) {
+            if (!has_read_) {
+               // Completion handlers must not be called from within
+               // the initiating function.
+               ec_ = ec;
+               yield boost::asio::post(std::move(self));
+               ec = ec_;
             }
 
-            n = parser_.bulk_length() + 2;
-            BOOST_ASSERT(buf_.size() >= n);
-         }
+            if (ec) {
+               self.complete(ec, 0);
+               return;
+            }
 
-         n = parser_.consume(static_cast<char const*>(buf_.data(0, n).data()), n, ec);
-         if (ec) {
-            self.complete(ec, 0);
+            self.complete({}, consumed_);
             return;
          }
 
-         buf_.consume(n);
-         consumed_ += n;
-         if (parser_.done()) {
-            self.complete({}, consumed_);
-            return;
+         has_read_ = true;
+         if (direct_buffer(parser_, buf_.size()).size() != 0) {
+            yield
+            boost::asio::async_read(
+               stream_,
+               direct_buffer(parser_, buf_.size()),
+               std::move(self));
+            AEDIS_CHECK_OP1();
+            parser_.commit_bulk(n);
+            consumed_ += n;
+            continue;
          }
+
+         yield
+         async_read_at_least(
+            stream_,
+            buf_,
+            missing_size(parser_, buf_.size()),
+            std::move(self));
+         AEDIS_CHECK_OP1();
       }
    }
 };
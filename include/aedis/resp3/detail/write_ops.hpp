@@ -0,0 +1,619 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_RESP3_WRITE_OPS_HPP
+#define AEDIS_RESP3_WRITE_OPS_HPP
+
+#include <cerrno>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/compose.hpp>
+#include <boost/asio/coroutine.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/socket_base.hpp>
+#include <boost/asio/basic_stream_socket.hpp>
+#include <boost/core/ignore_unused.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include <aedis/resp3/request.hpp>
+#include <aedis/resp3/detail/read_ops.hpp>
+
+#if !defined(_WIN32)
+#  include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#  define AEDIS_RESP3_SENDFILE
+#  include <sys/sendfile.h>
+#endif
+
+#include <boost/asio/yield.hpp>
+
+namespace aedis::resp3::detail {
+
+// The size of the chunks in which files are read when they can't be
+// sent with sendfile.
+constexpr std::size_t file_chunk_size = 64 * 1024;
+
+/* A buffer sequence that interleaves the bytes [begin, end) of a
+ * payload with the borrowed data of the segments [first, last), see
+ * request::segments. Refers to both without copying. The segments
+ * must not refer to files.
+ */
+template <class Segments>
+class gather_buffers {
+public:
+   gather_buffers(
+      boost::string_view payload,
+      Segments const& segments,
+      std::size_t first,
+      std::size_t last,
+      std::size_t begin,
+      std::size_t end) noexcept
+   : payload_{payload.data() + begin, end - begin}
+   , segments_{&segments}
+   , first_{first}
+   , last_{last}
+   , begin_{begin}
+   { }
+
+   gather_buffers(boost::string_view payload, Segments const& segments) noexcept
+   : gather_buffers{payload, segments, 0, std::size(segments), 0, payload.size()}
+   { }
+
+   class const_iterator {
+   public:
+      using iterator_category = std::bidirectional_iterator_tag;
+      using value_type = boost::asio::const_buffer;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = value_type;
+
+      const_iterator() = default;
+
+      // Even positions refer to the payload, odd ones to the
+      // segments.
+      auto operator*() const noexcept -> value_type
+      {
+         auto const& segs = *segments_;
+         auto const j = first_ + i_ / 2;
+         if (i_ % 2 != 0)
+            return boost::asio::buffer(segs[j].data.data(), segs[j].data.size());
+
+         auto const begin = j == first_ ? 0 : segs[j - 1].offset - begin_;
+         auto const end = j == last_ ? payload_.size() : segs[j].offset - begin_;
+         return boost::asio::buffer(payload_.data() + begin, end - begin);
+      }
+
+      auto operator++() noexcept -> const_iterator& { ++i_; return *this; }
+      auto operator++(int) noexcept -> const_iterator { auto tmp = *this; ++i_; return tmp; }
+      auto operator--() noexcept -> const_iterator& { --i_; return *this; }
+      auto operator--(int) noexcept -> const_iterator { auto tmp = *this; --i_; return tmp; }
+
+      friend auto operator==(const_iterator a, const_iterator b) noexcept { return a.i_ == b.i_; }
+      friend auto operator!=(const_iterator a, const_iterator b) noexcept { return a.i_ != b.i_; }
+
+   private:
+      friend class gather_buffers;
+
+      // Copies the state, the sequence may be moved while iterators
+      // to it are in use.
+      const_iterator(gather_buffers const& seq, std::size_t i) noexcept
+      : payload_{seq.payload_}
+      , segments_{seq.segments_}
+      , first_{seq.first_}
+      , last_{seq.last_}
+      , begin_{seq.begin_}
+      , i_{i}
+      {}
+
+      boost::string_view payload_;
+      Segments const* segments_ = nullptr;
+      std::size_t first_ = 0;
+      std::size_t last_ = 0;
+      std::size_t begin_ = 0;
+      std::size_t i_ = 0;
+   };
+
+   auto begin() const noexcept { return const_iterator{*this, 0}; }
+   auto end() const noexcept { return const_iterator{*this, 2 * (last_ - first_) + 1}; }
+
+private:
+   boost::string_view payload_;
+   Segments const* segments_ = nullptr;
+   std::size_t first_ = 0;
+   std::size_t last_ = 0;
+   std::size_t begin_ = 0;
+};
+
+// Returns the index of the first segment at or after i that refers
+// to a file.
+template <class Segments>
+auto next_file(Segments const& segments, std::size_t i) noexcept -> std::size_t
+{
+   for (; i < std::size(segments) && segments[i].file.fd < 0; ++i);
+   return i;
+}
+
+// Reads up to n bytes of the file starting pos bytes after its
+// offset.
+inline auto
+read_file(
+   file_arg const& file,
+   std::uint64_t pos,
+   char* data,
+   std::size_t n,
+   boost::system::error_code& ec) -> std::size_t
+{
+#if defined(_WIN32)
+   boost::ignore_unused(file, pos, data, n);
+   ec = boost::asio::error::operation_not_supported;
+   return 0;
+#else
+   for (;;) {
+      auto const ret = ::pread(file.fd, data, n, static_cast<off_t>(file.offset + pos));
+      if (ret < 0 && errno == EINTR)
+         continue;
+
+      if (ret < 0) {
+         ec.assign(errno, boost::system::system_category());
+         return 0;
+      }
+
+      // The file is shorter than the size in the request.
+      if (ret == 0) {
+         ec = boost::asio::error::eof;
+         return 0;
+      }
+
+      return static_cast<std::size_t>(ret);
+   }
+#endif
+}
+
+#if defined(AEDIS_RESP3_SENDFILE)
+// Sends the file starting pos bytes after its offset until the
+// socket would block.
+inline auto
+send_file(
+   int socket,
+   file_arg const& file,
+   std::uint64_t pos,
+   boost::system::error_code& ec) -> std::size_t
+{
+   auto const start = pos;
+   while (pos < file.size) {
+      auto off = static_cast<off_t>(file.offset + pos);
+      auto const ret = ::sendfile(socket, file.fd, &off, file.size - pos);
+      if (ret < 0 && errno == EINTR)
+         continue;
+
+      if (ret < 0) {
+         ec.assign(errno, boost::system::system_category());
+         break;
+      }
+
+      if (ret == 0) {
+         ec = boost::asio::error::eof;
+         break;
+      }
+
+      pos += static_cast<std::uint64_t>(ret);
+   }
+
+   return pos - start;
+}
+#endif
+
+template <class>
+struct is_tcp_socket : std::false_type {};
+
+template <class Executor>
+struct is_tcp_socket<boost::asio::basic_stream_socket<boost::asio::ip::tcp, Executor>> : std::true_type {};
+
+template <class SyncWriteStream>
+auto write_file(SyncWriteStream& stream, file_arg const& file, boost::system::error_code& ec) -> std::size_t
+{
+#if defined(AEDIS_RESP3_SENDFILE)
+   if constexpr (is_tcp_socket<SyncWriteStream>::value) {
+      std::uint64_t done = 0;
+      while (done < file.size) {
+         done += send_file(stream.native_handle(), file, done, ec);
+         if (ec == boost::asio::error::would_block) {
+            ec = {};
+            stream.wait(boost::asio::socket_base::wait_write, ec);
+         }
+
+         if (ec)
+            return 0;
+      }
+
+      return file.size;
+   }
+#endif
+
+   std::unique_ptr<char[]> buffer{new char[file_chunk_size]};
+   std::uint64_t done = 0;
+   while (done < file.size) {
+      auto const n = read_file(file, done, buffer.get(), (std::min)(file_chunk_size, static_cast<std::size_t>(file.size - done)), ec);
+      if (ec)
+         return 0;
+
+      boost::asio::write(stream, boost::asio::buffer(buffer.get(), n), ec);
+      if (ec)
+         return 0;
+
+      done += n;
+   }
+
+   return file.size;
+}
+
+// Writes the payload with the data of its segments inserted.
+template <class SyncWriteStream, class Segments>
+auto
+write_payload(
+   SyncWriteStream& stream,
+   boost::string_view payload,
+   Segments const& segments,
+   boost::system::error_code& ec) -> std::size_t
+{
+   std::size_t written = 0;
+   std::size_t pos = 0;
+   for (std::size_t first = 0;;) {
+      auto const next = next_file(segments, first);
+      auto const end = next == std::size(segments) ? payload.size() : segments[next].offset;
+      written += boost::asio::write(stream, gather_buffers<Segments>{payload, segments, first, next, pos, end}, ec);
+      if (ec)
+         return 0;
+
+      if (next == std::size(segments))
+         return written;
+
+      written += write_file(stream, segments[next].file, ec);
+      if (ec)
+         return 0;
+
+      pos = end;
+      first = next + 1;
+   }
+}
+
+#if defined(AEDIS_RESP3_SENDFILE)
+template <class Socket>
+struct sendfile_op {
+   Socket* socket;
+   file_arg file;
+   std::uint64_t done = 0;
+   bool non_blocking = false;
+   boost::asio::coroutine coro{};
+
+   template <class Self>
+   void operator()(Self& self, boost::system::error_code ec = {})
+   {
+      reenter (coro) for (;;)
+      {
+         yield socket->async_wait(boost::asio::socket_base::wait_write, std::move(self));
+         AEDIS_CHECK_OP1();
+
+         // The mode is restored after each call so that the socket
+         // is left as the user configured it.
+         non_blocking = socket->native_non_blocking();
+         socket->native_non_blocking(true, ec);
+         if (!ec) {
+            done += send_file(socket->native_handle(), file, done, ec);
+            boost::system::error_code ignored;
+            socket->native_non_blocking(non_blocking, ignored);
+         }
+
+         if (ec == boost::asio::error::would_block)
+            continue;
+
+         if (ec) {
+            self.complete(ec, 0);
+            return;
+         }
+
+         self.complete({}, file.size);
+         return;
+      }
+   }
+};
+#endif
+
+template <class AsyncWriteStream>
+struct copy_file_op {
+   AsyncWriteStream* stream;
+   file_arg file;
+   std::unique_ptr<char[]> buffer = nullptr;
+   std::uint64_t done = 0;
+   boost::asio::coroutine coro{};
+
+   template <class Self>
+   void operator()( Self& self
+                  , boost::system::error_code ec = {}
+                  , std::size_t n = 0)
+   {
+      reenter (coro)
+      {
+         // Completion handlers must not be called from within the
+         // initiating function.
+         yield boost::asio::post(std::move(self));
+
+         buffer.reset(new char[file_chunk_size]);
+         while (done < file.size) {
+            n = read_file(file, done, buffer.get(), (std::min)(file_chunk_size, static_cast<std::size_t>(file.size - done)), ec);
+            if (ec) {
+               self.complete(ec, 0);
+               return;
+            }
+
+            yield boost::asio::async_write(*stream, boost::asio::buffer(buffer.get(), n), std::move(self));
+            AEDIS_CHECK_OP1();
+            done += n;
+         }
+
+         self.complete({}, file.size);
+      }
+   }
+};
+
+template <class AsyncWriteStream, class CompletionToken>
+auto async_write_file(AsyncWriteStream& stream, file_arg const& file, CompletionToken&& token)
+{
+#if defined(AEDIS_RESP3_SENDFILE)
+   if constexpr (is_tcp_socket<AsyncWriteStream>::value) {
+      return boost::asio::async_compose
+         < CompletionToken
+         , void(boost::system::error_code, std::size_t)
+         >(sendfile_op<AsyncWriteStream>{&stream, file}, token, stream);
+   } else
+#endif
+   {
+      return boost::asio::async_compose
+         < CompletionToken
+         , void(boost::system::error_code, std::size_t)
+         >(copy_file_op<AsyncWriteStream>{&stream, file}, token, stream);
+   }
+}
+
+template <class AsyncWriteStream, class Segments>
+struct write_payload_op {
+   AsyncWriteStream* stream;
+   boost::string_view payload;
+   Segments const* segments;
+   std::size_t first = 0;
+   std::size_t next = 0;
+   std::size_t pos = 0;
+   std::size_t written = 0;
+   boost::asio::coroutine coro{};
+
+   auto end() const noexcept
+      { return next == std::size(*segments) ? payload.size() : (*segments)[next].offset; }
+
+   template <class Self>
+   void operator()( Self& self
+                  , boost::system::error_code ec = {}
+                  , std::size_t n = 0)
+   {
+      reenter (coro) for (;;)
+      {
+         next = next_file(*segments, first);
+
+         yield
+         boost::asio::async_write(
+            *stream,
+            gather_buffers<Segments>{payload, *segments, first, next, pos, end()},
+            std::move(self));
+         AEDIS_CHECK_OP1();
+
+         written += n;
+         if (next == std::size(*segments)) {
+            self.complete({}, written);
+            return;
+         }
+
+         yield async_write_file(*stream, (*segments)[next].file, std::move(self));
+         AEDIS_CHECK_OP1();
+
+         written += n;
+         pos = end();
+         first = next + 1;
+      }
+   }
+};
+
+template <class AsyncWriteStream, class Segments, class CompletionToken>
+auto
+async_write_payload(
+   AsyncWriteStream& stream,
+   boost::string_view payload,
+   Segments const& segments,
+   CompletionToken&& token)
+{
+   return boost::asio::async_compose
+      < CompletionToken
+      , void(boost::system::error_code, std::size_t)
+      >(write_payload_op<AsyncWriteStream, Segments>{&stream, payload, &segments}, token, stream);
+}
+
+/* The requests written together by the connection. The buffers point
+ * at the payloads and borrowed data of the requests, which must
+ * outlive the write, and files are written before the buffer at the
+ * given index.
+ */
+class write_batch {
+public:
+   explicit write_batch(std::pmr::memory_resource* resource)
+   : buffers_{resource}
+   , files_{resource}
+   { }
+
+   void add(request const& req)
+   {
+      boost::string_view const payload{req.payload().data(), req.payload().size()};
+
+      std::size_t pos = 0;
+      for (auto const& seg : req.segments()) {
+         add(payload.substr(pos, seg.offset - pos));
+         if (seg.file.fd >= 0) {
+            files_.push_back({std::size(buffers_), seg.file});
+            size_ += seg.file.size;
+         } else {
+            add(seg.data);
+         }
+
+         pos = seg.offset;
+      }
+
+      add(payload.substr(pos));
+      commands_ += req.size();
+   }
+
+   void clear()
+   {
+      buffers_.clear();
+      files_.clear();
+      size_ = 0;
+      commands_ = 0;
+   }
+
+   // Both batches must use the same memory resource.
+   void swap(write_batch& other) noexcept
+   {
+      buffers_.swap(other.buffers_);
+      files_.swap(other.files_);
+      std::swap(size_, other.size_);
+      std::swap(commands_, other.commands_);
+   }
+
+   [[nodiscard]] auto empty() const noexcept
+      { return buffers_.empty() && files_.empty(); }
+
+   // The number of bytes in the batch, including files.
+   [[nodiscard]] auto size() const noexcept
+      { return size_; }
+
+   // The number of commands in the batch.
+   [[nodiscard]] auto commands() const noexcept
+      { return commands_; }
+
+   [[nodiscard]] auto buffers() const noexcept -> auto const&
+      { return buffers_; }
+
+   [[nodiscard]] auto files() const noexcept -> auto const&
+      { return files_; }
+
+private:
+   void add(boost::string_view data)
+   {
+      if (!data.empty())
+         buffers_.push_back(boost::asio::buffer(data.data(), data.size()));
+
+      size_ += data.size();
+   }
+
+   std::pmr::vector<boost::asio::const_buffer> buffers_;
+   std::pmr::vector<std::pair<std::size_t, file_arg>> files_;
+   std::size_t size_ = 0;
+   std::size_t commands_ = 0;
+};
+
+// The buffers [first, last) of a batch.
+struct buffer_range {
+   boost::asio::const_buffer const* first;
+   boost::asio::const_buffer const* last;
+
+   auto begin() const noexcept { return first; }
+   auto end() const noexcept { return last; }
+};
+
+template <class AsyncWriteStream>
+struct write_batch_op {
+   AsyncWriteStream* stream;
+   write_batch const* batch;
+   std::size_t buffer = 0;
+   std::size_t file = 0;
+   std::size_t written = 0;
+   boost::asio::coroutine coro{};
+
+   // The end of the buffers that are written before the next file.
+   auto last() const noexcept
+   {
+      return file == std::size(batch->files())
+         ? std::size(batch->buffers())
+         : batch->files()[file].first;
+   }
+
+   template <class Self>
+   void operator()( Self& self
+                  , boost::system::error_code ec = {}
+                  , std::size_t n = 0)
+   {
+      reenter (coro)
+      {
+         if (batch->empty()) {
+            yield boost::asio::post(std::move(self));
+            self.complete({}, 0);
+            return;
+         }
+
+         for (;;) {
+            if (buffer != last()) {
+               yield
+               boost::asio::async_write(
+                  *stream,
+                  buffer_range{batch->buffers().data() + buffer, batch->buffers().data() + last()},
+                  std::move(self));
+               AEDIS_CHECK_OP1();
+
+               written += n;
+               buffer = last();
+            }
+
+            if (file == std::size(batch->files())) {
+               self.complete({}, written);
+               return;
+            }
+
+            yield async_write_file(*stream, batch->files()[file].second, std::move(self));
+            AEDIS_CHECK_OP1();
+
+            written += n;
+            ++file;
+         }
+      }
+   }
+};
+
+// Writes the batch with gather writes, files are sent as in
+// async_write_payload.
+template <class AsyncWriteStream, class CompletionToken>
+auto async_write_batch(AsyncWriteStream& stream, write_batch const& batch, CompletionToken&& token)
+{
+   return boost::asio::async_compose
+      < CompletionToken
+      , void(boost::system::error_code, std::size_t)
+      >(write_batch_op<AsyncWriteStream>{&stream, &batch}, token, stream);
+}
+
+} // aedis::resp3::detail
+
+#include <boost/asio/unyield.hpp>
+
+#endif // AEDIS_RESP3_WRITE_OPS_HPP
@@ -10,15 +10,35 @@ namespace aedis::resp3::detail {
 
 auto has_push_response(boost::string_view cmd) -> bool
 {
-   if (cmd == "SUBSCRIBE") return true;
-   if (cmd == "PSUBSCRIBE") return true;
-   if (cmd == "UNSUBSCRIBE") return true;
-   return false;
+   auto const* info = cmd::lookup(cmd);
+   return info != nullptr && info->has_push_response();
 }
 
 auto is_hello(boost::string_view cmd) -> bool
 {
-   return cmd == "HELLO";
+   auto const* info = cmd::lookup(cmd);
+   return info != nullptr && info == cmd::lookup("HELLO");
+}
+
+auto is_splittable(boost::string_view cmd) -> bool
+{
+   auto const* info = cmd::lookup(cmd);
+   return info != nullptr && info->is_splittable();
+}
+
+auto number_merge(boost::string_view cmd) -> merge
+{
+   auto const* info = cmd::lookup(cmd);
+   if (info == nullptr)
+      return merge::sum;
+
+   // Return the length of the list or whether it was modified.
+   for (auto const* name : {"RPUSH", "LPUSH", "RPUSHX", "LPUSHX", "PFADD"}) {
+      if (info == cmd::lookup(name))
+         return merge::max;
+   }
+
+   return merge::sum;
 }
 
 } // aedis::resp3::detail
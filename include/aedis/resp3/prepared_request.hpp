@@ -0,0 +1,173 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_RESP3_PREPARED_REQUEST_HPP
+#define AEDIS_RESP3_PREPARED_REQUEST_HPP
+
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <memory_resource>
+
+#include <boost/throw_exception.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include <aedis/command.hpp>
+#include <aedis/resp3/request.hpp>
+
+namespace aedis::resp3 {
+
+/** \brief A request whose arguments can be replaced in place.
+ *  \ingroup high-level-api
+ *
+ *  The commands are pushed once and each argument becomes a slot,
+ *  numbered in the order it was pushed, whose value can later be
+ *  rebound with bind(). Only the bulk of the affected argument is
+ *  rewritten, which is a plain copy if the new value has the same
+ *  length as the old one. For example
+ *
+ *  @code
+ *  prepared_request req;
+ *  req.push("SET", "key", ""); // Slots 0 and 1.
+ *
+ *  for (;;) {
+ *     req.bind(1, value);
+ *     co_await conn->async_exec(req.get(), adapt(resp));
+ *  }
+ *  @endcode
+ *
+ *  The arguments must not be rebound while an operation that uses
+ *  the request is pending.
+ */
+class prepared_request {
+public:
+   /** \brief Constructor
+    *
+    *  \param cfg Configuration options.
+    *  \param resource Memory resource.
+    */
+   explicit
+   prepared_request(
+      request::config cfg = request::config{false, true, false, true, true, 0, 0},
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+   : req_{cfg, resource}
+   , scratch_{resource}
+   { }
+
+   /// Returns the request, e.g. to pass it to aedis::connection::async_exec.
+   [[nodiscard]] auto get() const noexcept -> request const& { return req_; }
+
+   /// Same as get().
+   operator request const&() const noexcept { return req_; }
+
+   /// Returns the number of slots.
+   [[nodiscard]] auto slots() const noexcept -> std::size_t { return slots_.size(); }
+
+   /// Returns a reference to the config object.
+   [[nodiscard]] auto get_config() noexcept -> auto& { return req_.get_config(); }
+
+   /// Removes all commands and slots preserving allocated memory.
+   void clear()
+   {
+      req_.clear();
+      slots_.clear();
+   }
+
+   /** @brief Appends a new command to the end of the request.
+    *
+    *  Same as request::push, each argument becomes a slot.
+    */
+   template <class... Ts>
+   void push(boost::string_view cmd, Ts const&... args)
+   {
+      req_.grow(detail::header_size(1 + sizeof...(Ts))
+         + detail::serialized_size(cmd)
+         + (std::size_t{0} + ... + detail::serialized_size(args)));
+
+      detail::add_header(req_.payload_, type::array, 1 + sizeof...(Ts));
+      detail::add_bulk(req_.payload_, cmd);
+      (add_slot(args), ...);
+      req_.check_cmd(cmd);
+   }
+
+   /** @brief Appends a command from the aedis::cmd catalogue.
+    *
+    *  Same as request::push, each argument becomes a slot.
+    */
+   template <std::size_t Args, class... Ts>
+   void push(cmd::command<Args> const& c, Ts const&... args)
+   {
+      static_assert(
+         Args == (std::size_t{0} + ... + detail::bulk_counter<Ts>::size),
+         "Wrong number of arguments for the command.");
+
+      auto const header = c.header();
+      req_.grow(header.size() + (std::size_t{0} + ... + detail::serialized_size(args)));
+
+      req_.payload_.append(header.data(), header.size());
+      (add_slot(args), ...);
+      req_.check_cmd(c.has_push_response(), c.is_hello());
+   }
+
+   /** @brief Replaces the value of a slot.
+    *
+    *  \param i The slot, in the order the arguments were pushed.
+    *  \param value The new value, serialized as in request::push.
+    */
+   template <class T>
+   void bind(std::size_t i, T const& value)
+   {
+      if (i >= slots_.size())
+         BOOST_THROW_EXCEPTION(std::out_of_range{"aedis::resp3::prepared_request::bind"});
+
+      if constexpr (std::is_convertible<T const&, boost::string_view>::value) {
+         boost::string_view const data{value};
+         if (detail::bulk_size(data.size()) == slots_[i].size) {
+            // Same length, the header doesn't change.
+            auto const offset = slots_[i].offset + detail::header_size(data.size());
+            std::memcpy(&req_.payload_[offset], data.data(), data.size());
+            return;
+         }
+      }
+
+      scratch_.clear();
+      detail::add_bulk(scratch_, value);
+      replace(i, scratch_);
+   }
+
+private:
+   struct slot {
+      std::size_t offset;
+      std::size_t size;
+   };
+
+   template <class T>
+   void add_slot(T const& arg)
+   {
+      auto const offset = req_.payload_.size();
+      detail::add_bulk(req_.payload_, arg);
+      slots_.push_back({offset, req_.payload_.size() - offset});
+   }
+
+   void replace(std::size_t i, boost::string_view bulk)
+   {
+      req_.payload_.replace(slots_[i].offset, slots_[i].size, bulk.data(), bulk.size());
+
+      auto const old_size = slots_[i].size;
+      slots_[i].size = bulk.size();
+      for (auto j = i + 1; j < slots_.size(); ++j)
+         slots_[j].offset = slots_[j].offset + bulk.size() - old_size;
+   }
+
+   request req_;
+   std::vector<slot> slots_;
+   std::pmr::string scratch_;
+};
+
+} // aedis::resp3
+
+#endif // AEDIS_RESP3_PREPARED_REQUEST_HPP
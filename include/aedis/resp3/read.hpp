@@ -8,6 +8,7 @@
 #define AEDIS_RESP3_READ_HPP
 
 #include <aedis/resp3/type.hpp>
+#include <aedis/resp3/read_buffer.hpp>
 #include <aedis/resp3/detail/parser.hpp>
 #include <aedis/resp3/detail/read_ops.hpp>
 
@@ -25,23 +26,27 @@ namespace aedis::resp3 {
  *
  *  @code
  *  int resp;
- *  std::string buffer;
- *  resp3::read(socket, dynamic_buffer(buffer), adapt(resp));
+ *  resp3::read_buffer buffer;
+ *  resp3::read(socket, resp3::dynamic_buffer(buffer), adapt(resp));
  *  @endcode
  *
  *  For a complete example see examples/intro_sync.cpp. This function
  *  is implemented in terms of one or more calls to @c
- *  asio::read_until and @c asio::read functions, and is known as a @a
- *  composed @a operation. Furthermore, the implementation may read
- *  additional bytes from the stream that lie past the end of the
- *  message being read. These additional bytes are stored in the
- *  dynamic buffer, which must be preserved for subsequent reads.
+ *  asio::read functions, and is known as a @a composed @a operation.
+ *  All complete lines that are already in the buffer are parsed
+ *  before the stream is read again. Furthermore, the implementation
+ *  may read additional bytes from the stream that lie past the end
+ *  of the message being read. These additional bytes are stored in
+ *  the dynamic buffer, which must be preserved for subsequent reads.
+ *  Any DynamicBuffer_v2 works, but resp3::read_buffer avoids moving
+ *  the remaining bytes each time a chunk is consumed.
  *
  *  \param stream The stream from which to read e.g. a tcp socket.
  *  \param buf Dynamic buffer (version 2).
  *  \param adapter The response adapter.
  *  \param ec If an error occurs, it will be assigned to this paramter.
- *  \returns The number of bytes that have been consumed from the dynamic buffer.
+ *  \returns The number of bytes that have been consumed from the
+ *  dynamic buffer or read directly into the adapter's storage.
  *
  *  \remark This function calls buf.consume() in each chunk of data
  *  after it has been passed to the adapter. Users must not consume
@@ -60,34 +65,39 @@ read(
    boost::system::error_code& ec) -> std::size_t
 {
    detail::parser<ResponseAdapter> p {adapter};
-   std::size_t n = 0;
    std::size_t consumed = 0;
-   do {
-      if (p.bulk() == type::invalid) {
-	 n = boost::asio::read_until(stream, buf, "\r\n", ec);
-	 if (ec)
-	    return 0;
-
-      } else {
-	 auto const s = buf.size();
-	 auto const l = p.bulk_length();
-	 if (s < (l + 2)) {
-	    auto const to_read = l + 2 - s;
-	    buf.grow(to_read);
-	    n = boost::asio::read(stream, buf.data(s, to_read), ec);
-	    if (ec)
-	       return 0;
-	 }
-      }
+   for (;;) {
+      auto const n =
+         detail::consume_available(
+            p,
+            static_cast<char const*>(buf.data(0, buf.size()).data()),
+            buf.size(),
+            ec);
+
+      buf.consume(n);
+      consumed += n;
 
-      auto const* data = static_cast<char const*>(buf.data(0, n).data());
-      n = p.consume(data, n, ec);
       if (ec)
          return 0;
 
-      buf.consume(n);
-      consumed += n;
-   } while (!p.done());
+      if (p.done())
+         break;
+
+      auto const direct = detail::direct_buffer(p, buf.size());
+      if (direct.size() != 0) {
+         auto const m = boost::asio::read(stream, direct, ec);
+         if (ec)
+            return 0;
+
+         p.commit_bulk(m);
+         consumed += m;
+         continue;
+      }
+
+      detail::read_at_least(stream, buf, detail::missing_size(p, buf.size()), ec);
+      if (ec)
+         return 0;
+   }
 
    return consumed;
 }
@@ -123,19 +133,22 @@ read(
  *  server push asynchronously. For example
  *
  *  @code
- *  std::string buffer;
+ *  resp3::read_buffer buffer;
  *  std::set<std::string> resp;
- *  co_await resp3::async_read(socket, dynamic_buffer(buffer), adapt(resp));
+ *  co_await resp3::async_read(socket, resp3::dynamic_buffer(buffer), adapt(resp));
  *  @endcode
  *
  *  For a complete example see examples/transaction.cpp. This function
  *  is implemented in terms of one or more calls to @c
- *  asio::async_read_until and @c asio::async_read functions, and is
- *  known as a @a composed @a operation.  Furthermore, the
- *  implementation may read additional bytes from the stream that lie
- *  past the end of the message being read. These additional bytes are
- *  stored in the dynamic buffer, which must be preserved for
- *  subsequent reads.
+ *  asio::async_read functions, and is known as a @a composed @a
+ *  operation. All complete lines that are already in the buffer are
+ *  parsed before the stream is read again, so it suspends only when
+ *  the buffer runs dry. Furthermore, the implementation may read
+ *  additional bytes from the stream that lie past the end of the
+ *  message being read. These additional bytes are stored in the
+ *  dynamic buffer, which must be preserved for subsequent reads.
+ *  Any DynamicBuffer_v2 works, but resp3::read_buffer avoids moving
+ *  the remaining bytes each time a chunk is consumed.
  *
  *  \param stream The stream from which to read e.g. a tcp socket.
  *  \param buffer Dynamic buffer (version 2).
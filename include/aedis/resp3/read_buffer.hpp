@@ -0,0 +1,208 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_RESP3_READ_BUFFER_HPP
+#define AEDIS_RESP3_READ_BUFFER_HPP
+
+#include <limits>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <memory_resource>
+
+#include <boost/assert.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/asio/buffer.hpp>
+
+namespace aedis::resp3 {
+
+/** \brief Storage for data read from a Redis connection.
+ *  \ingroup low-level-api
+ *
+ *  Unlike a plain @c std::string wrapped in @c asio::dynamic_buffer,
+ *  where consuming bytes erases them from the front of the string,
+ *  this buffer keeps separate read and write cursors. Consuming
+ *  bytes only advances the read cursor, so parsing a response costs
+ *  no copies regardless of how many bytes follow it in the buffer.
+ *  The unread bytes are moved to the front only when the buffer
+ *  needs to grow and at least half of its contents have already been
+ *  consumed, which keeps the cost of compaction amortized constant
+ *  per byte.
+ *
+ *  @code
+ *  resp3::read_buffer buffer;
+ *  resp3::read(socket, resp3::dynamic_buffer(buffer), adapt(resp));
+ *  @endcode
+ */
+class read_buffer {
+public:
+   /// Constructs an empty buffer.
+   explicit
+   read_buffer(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+   : storage_{resource}
+   { }
+
+   /// Returns a pointer to the first unread byte.
+   auto data() const noexcept -> char const*
+      { return storage_.data() + begin_; }
+
+   /// Returns the number of unread bytes.
+   auto size() const noexcept -> std::size_t
+      { return end_ - begin_; }
+
+   /// Returns true if there are no unread bytes.
+   auto empty() const noexcept -> bool
+      { return begin_ == end_; }
+
+   /// Returns the first unread byte.
+   auto front() const noexcept -> char
+      { BOOST_ASSERT(!empty()); return storage_[begin_]; }
+
+   /// Returns the number of bytes the buffer can hold without reallocating.
+   auto capacity() const noexcept -> std::size_t
+      { return storage_.size() - begin_; }
+
+   /// Removes all bytes from the buffer.
+   void clear() noexcept
+      { begin_ = end_ = 0; }
+
+   /** \brief Appends n bytes of uninitialized space.
+    *
+    *  Previously returned pointers are invalidated.
+    *
+    *  @returns A pointer to the first of the appended bytes.
+    */
+   auto grow(std::size_t n) -> char*
+   {
+      if (storage_.size() - end_ < n) {
+         // Compacts only when the consumed prefix is at least as
+         // large as the data that has to be moved, otherwise grows
+         // the storage geometrically.
+         if (begin_ != 0 && begin_ >= size()) {
+            std::memmove(storage_.data(), storage_.data() + begin_, size());
+            end_ -= begin_;
+            begin_ = 0;
+         }
+
+         if (storage_.size() - end_ < n)
+            storage_.resize((std::max)(end_ + n, 2 * storage_.size()));
+      }
+
+      auto* const p = storage_.data() + end_;
+      end_ += n;
+      return p;
+   }
+
+   /// Removes n bytes from the end of the buffer.
+   void shrink(std::size_t n) noexcept
+      { end_ -= (std::min)(n, size()); }
+
+   /// Removes n bytes from the beginning of the buffer.
+   void consume(std::size_t n) noexcept
+   {
+      begin_ += (std::min)(n, size());
+      if (begin_ == end_)
+         begin_ = end_ = 0;
+   }
+
+private:
+   std::pmr::vector<char> storage_;
+   std::size_t begin_ = 0;
+   std::size_t end_ = 0;
+};
+
+/** \brief Adapts a read_buffer to the DynamicBuffer_v2 requirements.
+ *  \ingroup low-level-api
+ *
+ *  Objects of this class are lightweight handles that can be copied
+ *  and passed to resp3::read and resp3::async_read. Use
+ *  resp3::dynamic_buffer to create them.
+ */
+class dynamic_read_buffer {
+public:
+   /// The type used to represent the input sequence.
+   using const_buffers_type = boost::asio::const_buffer;
+
+   /// The type used to represent the output sequence.
+   using mutable_buffers_type = boost::asio::mutable_buffer;
+
+   /// Constructor.
+   explicit
+   dynamic_read_buffer(
+      read_buffer& buf,
+      std::size_t max_size = (std::numeric_limits<std::size_t>::max)()) noexcept
+   : buf_{&buf}
+   , max_size_{max_size}
+   { }
+
+   /// Returns the number of unread bytes.
+   auto size() const noexcept -> std::size_t
+      { return buf_->size(); }
+
+   /// Returns the maximum size the buffer may grow to.
+   auto max_size() const noexcept -> std::size_t
+      { return max_size_; }
+
+   /// Returns the number of bytes that can be held without reallocating.
+   auto capacity() const noexcept -> std::size_t
+      { return (std::min)(buf_->capacity(), max_size_); }
+
+   /// Returns a buffer for n bytes starting at position pos.
+   auto data(std::size_t pos, std::size_t n) const noexcept -> const_buffers_type
+   {
+      auto const size = buf_->size();
+      pos = (std::min)(pos, size);
+      return {buf_->data() + pos, (std::min)(n, size - pos)};
+   }
+
+   /// Returns a buffer for n bytes starting at position pos.
+   auto data(std::size_t pos, std::size_t n) noexcept -> mutable_buffers_type
+   {
+      auto const size = buf_->size();
+      pos = (std::min)(pos, size);
+      return {const_cast<char*>(buf_->data()) + pos, (std::min)(n, size - pos)};
+   }
+
+   /// Appends n bytes of uninitialized space.
+   void grow(std::size_t n)
+   {
+      if (size() > max_size_ || max_size_ - size() < n)
+         BOOST_THROW_EXCEPTION(std::length_error{"aedis::resp3::dynamic_read_buffer too long"});
+
+      buf_->grow(n);
+   }
+
+   /// Removes n bytes from the end of the buffer.
+   void shrink(std::size_t n) noexcept
+      { buf_->shrink(n); }
+
+   /// Removes n bytes from the beginning of the buffer.
+   void consume(std::size_t n) noexcept
+      { buf_->consume(n); }
+
+private:
+   read_buffer* buf_;
+   std::size_t max_size_;
+};
+
+/** \brief Creates a DynamicBuffer_v2 adapter for a read_buffer.
+ *  \ingroup low-level-api
+ *
+ *  \param buf The underlying storage, must outlive the adapter.
+ *  \param max_size The maximum size the buffer may grow to.
+ */
+inline
+auto dynamic_buffer(
+   read_buffer& buf,
+   std::size_t max_size = (std::numeric_limits<std::size_t>::max)()) noexcept
+{
+   return dynamic_read_buffer{buf, max_size};
+}
+
+} // aedis::resp3
+
+#endif // AEDIS_RESP3_READ_BUFFER_HPP
@@ -0,0 +1,145 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_RESP3_READER_HPP
+#define AEDIS_RESP3_READER_HPP
+
+#include <limits>
+#include <type_traits>
+
+#include <boost/throw_exception.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <aedis/resp3/read.hpp>
+#include <aedis/resp3/read_buffer.hpp>
+
+namespace aedis::resp3 {
+
+/** \brief Reads responses synchronously from a stream it doesn't own.
+ *  \ingroup low-level-api
+ *
+ *  Keeps the read buffer between calls so that all responses that
+ *  arrive in the same chunk of data are parsed from memory. The
+ *  stream is read only when the buffer runs dry and then with a
+ *  single @c read_some that is as large as the free space in the
+ *  buffer (at least 512 bytes and at most 64k), which means that
+ *  the responses to a small pipeline usually cost a single system
+ *  call. For example
+ *
+ *  @code
+ *  request req;
+ *  req.push("HELLO", 3);
+ *  req.push("PING");
+ *  req.push("GET", "key");
+ *  resp3::write(socket, req);
+ *
+ *  resp3::reader<tcp::socket> reader{socket};
+ *  resp3::response_view resp;
+ *  reader.read(req.size(), adapt2(resp));
+ *  @endcode
+ *
+ *  \tparam SyncReadStream A synchronous read stream, e.g. a tcp socket.
+ */
+template <class SyncReadStream>
+class reader {
+public:
+   /// The type of the next layer.
+   using next_layer_type = SyncReadStream;
+
+   /** \brief Constructor.
+    *
+    *  \param stream The stream to read from, must outlive the reader.
+    *  \param max_size The maximum size of the read buffer.
+    */
+   explicit
+   reader(
+      SyncReadStream& stream,
+      std::size_t max_size = (std::numeric_limits<std::size_t>::max)())
+   : stream_{&stream}
+   , max_size_{max_size}
+   { }
+
+   /// Returns a reference to the next layer.
+   auto next_layer() noexcept -> SyncReadStream& { return *stream_; }
+
+   /// Returns the data that has been read but not parsed yet.
+   auto buffer() const noexcept -> read_buffer const& { return buffer_; }
+
+   /** \brief Reads one response.
+    *
+    *  \param adapter The response adapter.
+    *  \param ec If an error occurs, it will be assigned to this paramter.
+    *  \returns The size of the response in bytes.
+    */
+   template <class ResponseAdapter>
+   auto read(ResponseAdapter adapter, boost::system::error_code& ec) -> std::size_t
+   {
+      return resp3::read(*stream_, dynamic_buffer(buffer_, max_size_), adapter, ec);
+   }
+
+   /** \brief Reads n responses.
+    *
+    *  All responses are passed to the same adapter, e.g. one that
+    *  fills a resp3::response_view or ignores them.
+    *
+    *  \param n The number of responses to read.
+    *  \param adapter The response adapter.
+    *  \param ec If an error occurs, it will be assigned to this paramter.
+    *  \returns The size of the responses in bytes.
+    */
+   template <class ResponseAdapter>
+   auto
+   read(
+      std::size_t n,
+      ResponseAdapter adapter,
+      boost::system::error_code& ec) -> std::size_t
+   {
+      std::size_t size = 0;
+      for (; n != 0; --n) {
+         size += read(adapter, ec);
+         if (ec)
+            return 0;
+      }
+
+      return size;
+   }
+
+   /** \brief Reads one response.
+    *
+    *  Same as the error_code overload but throws on error.
+    */
+   template <
+      class ResponseAdapter = detail::ignore_response,
+      class = std::enable_if_t<!std::is_integral<ResponseAdapter>::value>>
+   auto read(ResponseAdapter adapter = ResponseAdapter{}) -> std::size_t
+   {
+      return read(std::size_t{1}, adapter);
+   }
+
+   /** \brief Reads n responses.
+    *
+    *  Same as the error_code overload but throws on error.
+    */
+   template <class ResponseAdapter = detail::ignore_response>
+   auto read(std::size_t n, ResponseAdapter adapter = ResponseAdapter{}) -> std::size_t
+   {
+      boost::system::error_code ec;
+      auto const size = read(n, adapter, ec);
+      if (ec)
+         BOOST_THROW_EXCEPTION(boost::system::system_error{ec});
+
+      return size;
+   }
+
+private:
+   SyncReadStream* stream_;
+   std::size_t max_size_;
+   read_buffer buffer_;
+};
+
+} // aedis::resp3
+
+#endif // AEDIS_RESP3_READER_HPP
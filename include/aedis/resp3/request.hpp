@@ -9,11 +9,18 @@
 
 #include <string>
 #include <tuple>
+#include <utility>
+#include <cstdint>
+#include <algorithm>
+#include <charconv>
+#include <vector>
+#include <iterator>
+#include <type_traits>
 #include <memory_resource>
 
-#include <boost/hana.hpp>
 #include <boost/utility/string_view.hpp>
 
+#include <aedis/command.hpp>
 #include <aedis/resp3/type.hpp>
 
 // NOTE: Consider detecting tuples in the type in the parameter pack
@@ -26,6 +33,58 @@ namespace aedis::resp3 {
 
 constexpr char const* separator = "\r\n";
 
+namespace detail {
+
+// Enough for any 64-bit integer including the sign.
+constexpr std::size_t max_integer_size = 24;
+
+// std::to_chars doesn't take bool, std::to_string promoted it to int.
+template <class T>
+auto to_integer(T n) noexcept
+{
+   if constexpr (std::is_same<T, bool>::value)
+      return static_cast<int>(n);
+   else
+      return n;
+}
+
+// Writes n in decimal to buf and returns the number of characters.
+template <class T>
+auto integer_to_chars(char (&buf)[max_integer_size], T n) noexcept -> std::size_t
+{
+   auto const res = std::to_chars(buf, buf + max_integer_size, to_integer(n));
+   return static_cast<std::size_t>(res.ptr - buf);
+}
+
+template <class Request, class T>
+void add_integer(Request& to, T n)
+{
+   char buf[max_integer_size];
+   to.append(buf, integer_to_chars(buf, n));
+}
+
+// The number of characters of n in decimal.
+template <class T>
+auto integer_size(T n) noexcept -> std::size_t
+{
+   auto const v = to_integer(n);
+   std::size_t ret = 1;
+   auto m = static_cast<std::uint64_t>(v);
+   if constexpr (std::is_signed<decltype(v)>::value) {
+      if (v < 0) {
+         m = 0 - m;
+         ++ret;
+      }
+   }
+
+   for (; m >= 10; m /= 10)
+      ++ret;
+
+   return ret;
+}
+
+} // detail
+
 /** @brief Adds a bulk to the request.
  *  @relates request
  *
@@ -48,10 +107,8 @@ constexpr char const* separator = "\r\n";
 template <class Request>
 void to_bulk(Request& to, boost::string_view data)
 {
-   auto const str = std::to_string(data.size());
-
    to += to_code(type::blob_string);
-   to.append(std::cbegin(str), std::cend(str));
+   detail::add_integer(to, data.size());
    to += separator;
    to.append(std::cbegin(data), std::cend(data));
    to += separator;
@@ -60,16 +117,80 @@ void to_bulk(Request& to, boost::string_view data)
 template <class Request, class T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
 void to_bulk(Request& to, T n)
 {
-   auto const s = std::to_string(n);
-   to_bulk(to, boost::string_view{s});
+   char buf[detail::max_integer_size];
+   to_bulk(to, boost::string_view{buf, detail::integer_to_chars(buf, n)});
 }
 
+/** @brief An argument that is sent from memory owned by the caller.
+ *  @relates request
+ *
+ *  Requests store only the framing of such arguments and refer to
+ *  their data, which must therefore remain valid until the request
+ *  has been written, e.g. until aedis::connection::async_exec
+ *  completes. Useful to avoid copying large values, for example
+ *
+ *  @code
+ *  request req;
+ *  req.push("SET", "key", resp3::borrow(value));
+ *  @endcode
+ */
+struct borrowed_bulk {
+   /// The data.
+   boost::string_view data;
+};
+
+/** @brief Creates a borrowed_bulk.
+ *  @relates request
+ */
+inline auto borrow(boost::string_view data) noexcept -> borrowed_bulk
+   { return {data}; }
+
+/** @brief An argument whose data is read from a file.
+ *  @relates request
+ *
+ *  Like borrowed_bulk the request stores only the framing. The
+ *  connection sends the data with \c sendfile on Linux TCP sockets
+ *  and otherwise reads it in chunks, e.g. for ssl::connection. The
+ *  file descriptor must remain open until the request has been
+ *  written. For example
+ *
+ *  @code
+ *  request req;
+ *  req.push("SET", "key", resp3::file_arg{fd, 0, size});
+ *  @endcode
+ *
+ *  \remarks Only aedis::connection and the resp3::write overloads
+ *  support file arguments.
+ */
+struct file_arg {
+   /// The file descriptor, -1 if there is no file.
+   int fd = -1;
+
+   /// The position in the file where the data starts.
+   std::uint64_t offset = 0;
+
+   /// The size of the data.
+   std::size_t size = 0;
+};
+
 namespace detail {
 
 auto has_push_response(boost::string_view cmd) -> bool;
 
 auto is_hello(boost::string_view cmd) -> bool;
 
+auto is_splittable(boost::string_view cmd) -> bool;
+
+// How the top-level numbers in the responses of a command split by
+// push_range are merged, e.g. the number of elements added by SADD
+// is summed while the length of the list returned by RPUSH is not.
+enum class merge
+{ sum
+, max
+};
+
+auto number_merge(boost::string_view cmd) -> merge;
+
 template <class T>
 struct add_bulk_impl {
    template <class Request>
@@ -91,33 +212,46 @@ struct add_bulk_impl<std::pair<U, V>> {
    }
 };
 
-template <class ...Ts>
-struct add_bulk_impl<boost::hana::tuple<Ts...>> {
-   template <class Request>
-   static void add(Request& to, boost::hana::tuple<Ts...> const& from)
-   {
-      using boost::hana::for_each;
-
-      // Fold expressions is C++17 so we use hana.
-      //(detail::add_bulk(*request_, args), ...);
-
-      for_each(from, [&](auto const& e) {
-         using namespace aedis::resp3;
-         to_bulk(to, e);
-      });
-   }
-};
-
 template <class Request>
 void add_header(Request& to, type t, std::size_t size)
 {
-   auto const str = std::to_string(size);
-
    to += to_code(t);
-   to.append(std::cbegin(str), std::cend(str));
+   add_integer(to, size);
    to += separator;
 }
 
+// The size of a header or of a bulk with n bytes of data.
+inline auto header_size(std::size_t size) noexcept -> std::size_t
+   { return 1 + integer_size(size) + 2; }
+
+inline auto bulk_size(std::size_t n) noexcept -> std::size_t
+   { return header_size(n) + n + 2; }
+
+// The size data will have once serialized, or zero for types that
+// are serialized by a user defined to_bulk and can't be known
+// upfront.
+template <class T>
+auto serialized_size(T const& data) noexcept -> std::size_t
+{
+   if constexpr (std::is_integral<T>::value)
+      return bulk_size(integer_size(data));
+   else if constexpr (std::is_convertible<T const&, boost::string_view>::value)
+      return bulk_size(boost::string_view{data}.size());
+   else
+      return 0;
+}
+
+// Only the framing of borrowed data is stored.
+inline auto serialized_size(borrowed_bulk const& data) noexcept -> std::size_t
+   { return header_size(data.data.size()) + 2; }
+
+inline auto serialized_size(file_arg const& data) noexcept -> std::size_t
+   { return header_size(data.size) + 2; }
+
+template <class U, class V>
+auto serialized_size(std::pair<U, V> const& data) noexcept -> std::size_t
+   { return serialized_size(data.first) + serialized_size(data.second); }
+
 template <class Request, class T>
 void add_bulk(Request& to, T const& data)
 {
@@ -172,6 +306,8 @@ void add_separator(Request& to)
  *  \li Non-string types will be converted to string by using \c
  *  to_bulk, which must be made available over ADL.
  *  \li Uses std::string as internal storage.
+ *  \li Arguments wrapped with resp3::borrow are not copied, see
+ *  segments().
  */
 class request {
 public:
@@ -186,7 +322,8 @@ public:
 
       /** \brief If true this request will be coalesced with other requests,
        *  see https://redis.io/topics/pipelining. If false, this
-       *  request will be sent individually.
+       *  request will be sent individually and only when no
+       *  responses are pending, as will the requests after it.
        */
       bool coalesce = true;
 
@@ -210,6 +347,28 @@ public:
        * commands are sent.
        */
       bool hello_with_priority = true;
+
+      /** \brief If not zero, push_range splits ranges with more
+       *  elements than this in several commands of the same kind,
+       *  each with at most this number of elements, so that no
+       *  single command blocks Redis for too long. Pairs count as
+       *  one element. Only commands for which this doesn't change
+       *  the result are split, e.g. SADD but not SINTER, see
+       *  cmd::info::is_splittable.
+       *
+       *  The responses of the parts are merged in a single response:
+       *  aggregates are concatenated, top-level numbers are summed
+       *  (or, for commands like RPUSH whose reply is a length, the
+       *  maximum is taken) and the last value is kept for other
+       *  types. Notice that the parts are not executed atomically.
+       */
+      std::size_t max_range_size = 0;
+
+      /** \brief Same as max_range_size but limits the serialized size
+       *  of the elements in each part, in bytes. User types that
+       *  are converted with to_bulk are counted as zero bytes.
+       */
+      std::size_t max_range_bytes = 0;
    };
 
    /** \brief Constructor
@@ -218,17 +377,64 @@ public:
     *  \param resource Memory resource.
     */
     explicit
-    request(config cfg = config{false, true, false, true, true},
+    request(config cfg = config{false, true, false, true, true, 0, 0},
             std::pmr::memory_resource* resource = std::pmr::get_default_resource())
-    : cfg_{cfg}, payload_(resource) {}
+    : cfg_{cfg}, payload_(resource), segments_(resource), merged_(resource) {}
 
     //// Returns the number of commands contained in this request.
    [[nodiscard]] auto size() const noexcept -> std::size_t
       { return commands_;};
 
+   /** \brief Returns the number of responses, which is smaller than
+    *  size() if push_range split commands, see config::max_range_size.
+    */
+   [[nodiscard]] auto responses() const noexcept -> std::size_t
+      { return commands_ - merged_.size();};
+
+   /// A command whose response is merged with the previous one.
+   struct merged_command {
+      /// The position of the command, see size().
+      std::size_t index;
+
+      /// How top-level numbers are merged.
+      detail::merge numbers;
+
+      /** \brief The number of elements in the range of the split
+       *  command, which is the size of the merged response if it is
+       *  an aggregate, e.g. for MGET.
+       */
+      std::size_t elements;
+   };
+
+   /// Returns the commands whose response is merged with the previous one.
+   [[nodiscard]] auto merged() const noexcept -> auto const&
+      { return merged_;}
+
+   /// A borrowed or file argument and the position where it goes in the payload.
+   struct segment {
+      /// The offset in the payload where the data is inserted.
+      std::size_t offset;
+
+      /// The borrowed data.
+      boost::string_view data;
+
+      /// The file the data is read from, if any.
+      file_arg file = {};
+   };
+
+   /** \brief Returns the serialized request.
+    *
+    *  If the request has borrowed arguments the payload contains
+    *  only their framing and the data has to be inserted as given
+    *  by segments().
+    */
    [[nodiscard]] auto payload() const noexcept -> auto const&
       { return payload_;}
 
+   /// Returns the borrowed and file arguments in the order they were pushed.
+   [[nodiscard]] auto segments() const noexcept -> auto const&
+      { return segments_;}
+
    [[nodiscard]] auto has_hello_priority() const noexcept -> auto const&
       { return has_hello_priority_;}
 
@@ -236,6 +442,8 @@ public:
    void clear()
    {
       payload_.clear();
+      segments_.clear();
+      merged_.clear();
       commands_ = 0;
    }
 
@@ -267,18 +475,51 @@ public:
    template <class... Ts>
    void push(boost::string_view cmd, Ts const&... args)
    {
-      using boost::hana::for_each;
-      using boost::hana::make_tuple;
       using resp3::type;
 
       auto constexpr pack_size = sizeof...(Ts);
+      grow(detail::header_size(1 + pack_size)
+         + detail::serialized_size(cmd)
+         + (std::size_t{0} + ... + detail::serialized_size(args)));
+
       detail::add_header(payload_, type::array, 1 + pack_size);
       detail::add_bulk(payload_, cmd);
-      detail::add_bulk(payload_, make_tuple(args...));
+      (add_arg(args), ...);
 
       check_cmd(cmd);
    }
 
+   /** @brief Appends a command from the aedis::cmd catalogue to the
+    *  end of the request.
+    *
+    *  The command header is copied as is, only the arguments are
+    *  serialized. For example
+    *
+    *  \code
+    *  request req;
+    *  req.push(cmd::set, "key", "some string");
+    *  \endcode
+    *
+    *  \param c The command.
+    *  \param args Command arguments, their number must match the
+    *  command, pairs count as two.
+    */
+   template <std::size_t Args, class... Ts>
+   void push(cmd::command<Args> const& c, Ts const&... args)
+   {
+      static_assert(
+         Args == (std::size_t{0} + ... + detail::bulk_counter<Ts>::size),
+         "Wrong number of arguments for the command.");
+
+      auto const header = c.header();
+      grow(header.size() + (std::size_t{0} + ... + detail::serialized_size(args)));
+
+      payload_.append(header.data(), header.size());
+      (add_arg(args), ...);
+
+      check_cmd(c.has_push_response(), c.is_hello());
+   }
+
    /** @brief Appends a new command to the end of the request.
     *  
     *  This overload is useful for commands that have a key and have a
@@ -304,22 +545,10 @@ public:
    void push_range(boost::string_view cmd, Key const& key, ForwardIterator begin, ForwardIterator end,
                     typename std::iterator_traits<ForwardIterator>::value_type * = nullptr)
    {
-      using value_type = typename std::iterator_traits<ForwardIterator>::value_type;
-      using resp3::type;
-
       if (begin == end)
          return;
 
-      auto constexpr size = detail::bulk_counter<value_type>::size;
-      auto const distance = std::distance(begin, end);
-      detail::add_header(payload_, type::array, 2 + size * distance);
-      detail::add_bulk(payload_, cmd);
-      detail::add_bulk(payload_, key);
-
-      for (; begin != end; ++begin)
-	 detail::add_bulk(payload_, *begin);
-
-      check_cmd(cmd);
+      add_range(cmd, begin, end, key);
    }
 
    /** @brief Appends a new command to the end of the request.
@@ -343,21 +572,10 @@ public:
    void push_range(boost::string_view cmd, ForwardIterator begin, ForwardIterator end,
                    typename std::iterator_traits<ForwardIterator>::value_type * = nullptr)
    {
-      using value_type = typename std::iterator_traits<ForwardIterator>::value_type;
-      using resp3::type;
-
       if (begin == end)
          return;
 
-      auto constexpr size = detail::bulk_counter<value_type>::size;
-      auto const distance = std::distance(begin, end);
-      detail::add_header(payload_, type::array, 1 + size * distance);
-      detail::add_bulk(payload_, cmd);
-
-      for (; begin != end; ++begin)
-	 detail::add_bulk(payload_, *begin);
-
-      check_cmd(cmd);
+      add_range(cmd, begin, end);
    }
 
    /** @brief Appends a new command to the end of the request.
@@ -394,16 +612,127 @@ public:
    }
 
 private:
+   friend class prepared_request;
+
+   // Counts the elements in the range and their serialized size.
+   template <class ForwardIterator>
+   static auto
+   serialized_size(ForwardIterator begin, ForwardIterator end) -> std::pair<std::size_t, std::size_t>
+   {
+      std::size_t distance = 0;
+      std::size_t size = 0;
+      for (; begin != end; ++begin, ++distance)
+         size += detail::serialized_size(*begin);
+
+      return {distance, size};
+   }
+
+   // Adds the range as one command or, if it exceeds the limits in
+   // the config, as several commands whose responses are merged.
+   template <class ForwardIterator, class... Key>
+   void add_range(boost::string_view cmd, ForwardIterator begin, ForwardIterator end, Key const&... key)
+   {
+      auto const [distance, range_size] = serialized_size(begin, end);
+      if (!detail::is_splittable(cmd) ||
+          ((cfg_.max_range_size == 0 || distance <= cfg_.max_range_size) &&
+           (cfg_.max_range_bytes == 0 || range_size <= cfg_.max_range_bytes))) {
+         add_range_command(cmd, begin, end, distance, range_size, key...);
+         return;
+      }
+
+      auto const numbers = detail::number_merge(cmd);
+      for (auto first = true; begin != end; first = false) {
+         // Each part has at least one element.
+         auto last = begin;
+         std::size_t n = 0;
+         std::size_t size = 0;
+         do {
+            size += detail::serialized_size(*last);
+            ++last;
+            ++n;
+         } while (last != end
+            && (cfg_.max_range_size == 0 || n < cfg_.max_range_size)
+            && (cfg_.max_range_bytes == 0 || size + detail::serialized_size(*last) <= cfg_.max_range_bytes));
+
+         auto const index = commands_;
+         add_range_command(cmd, begin, last, n, size, key...);
+         if (!first && commands_ != index)
+            merged_.push_back({index, numbers, distance});
+
+         begin = last;
+      }
+   }
+
+   template <class ForwardIterator, class... Key>
+   void
+   add_range_command(
+      boost::string_view cmd,
+      ForwardIterator begin,
+      ForwardIterator end,
+      std::size_t distance,
+      std::size_t range_size,
+      Key const&... key)
+   {
+      using value_type = typename std::iterator_traits<ForwardIterator>::value_type;
+      using resp3::type;
+
+      auto constexpr size = detail::bulk_counter<value_type>::size;
+      grow(detail::header_size(1 + sizeof...(Key) + size * distance)
+         + detail::serialized_size(cmd)
+         + (std::size_t{0} + ... + detail::serialized_size(key))
+         + range_size);
+
+      detail::add_header(payload_, type::array, 1 + sizeof...(Key) + size * distance);
+      detail::add_bulk(payload_, cmd);
+      (add_arg(key), ...);
+
+      for (; begin != end; ++begin)
+	 add_arg(*begin);
+
+      check_cmd(cmd);
+   }
+
+   template <class T>
+   void add_arg(T const& arg)
+   {
+      if constexpr (std::is_same<T, borrowed_bulk>::value) {
+         detail::add_header(payload_, type::blob_string, arg.data.size());
+         segments_.push_back({payload_.size(), arg.data});
+         payload_ += separator;
+      } else if constexpr (std::is_same<T, file_arg>::value) {
+         detail::add_header(payload_, type::blob_string, arg.size);
+         segments_.push_back({payload_.size(), {}, arg});
+         payload_ += separator;
+      } else {
+         detail::add_bulk(payload_, arg);
+      }
+   }
+
+   // Makes room for n more bytes so that the payload is reallocated
+   // at most once per command, growing geometrically as
+   // std::string::reserve is not required to.
+   void grow(std::size_t n)
+   {
+      auto const needed = payload_.size() + n;
+      if (needed > payload_.capacity())
+         payload_.reserve((std::max)(needed, 2 * payload_.capacity()));
+   }
+
    void check_cmd(boost::string_view cmd)
+      { check_cmd(detail::has_push_response(cmd), detail::is_hello(cmd)); }
+
+   void check_cmd(bool has_push_response, bool is_hello)
    {
-      if (!detail::has_push_response(cmd))
+      if (!has_push_response)
          ++commands_;
 
-      has_hello_priority_ = detail::is_hello(cmd) && cfg_.hello_with_priority;
+      has_hello_priority_ = is_hello && cfg_.hello_with_priority;
    }
 
    config cfg_;
    std::pmr::string payload_;
+   std::pmr::vector<segment> segments_;
+   std::pmr::vector<merged_command> merged_;
    std::size_t commands_ = 0;
    bool has_hello_priority_ = false;
 };
@@ -0,0 +1,230 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_RESP3_RESPONSE_VIEW_HPP
+#define AEDIS_RESP3_RESPONSE_VIEW_HPP
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+
+#include <boost/assert.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include <aedis/resp3/type.hpp>
+#include <aedis/resp3/node.hpp>
+
+namespace aedis::resp3 {
+
+/** \brief A flat, read-only representation of responses.
+ *  \ingroup high-level-api
+ *
+ *  Like \c std::vector<node<std::string>> this type can hold any
+ *  response, but instead of allocating a string per node it copies
+ *  the values into a single buffer and stores only offsets into it.
+ *  Receiving a response costs therefore two allocations that are
+ *  amortized over subsequent responses, and walking it touches
+ *  contiguous memory. The nodes are stored in pre-order and can be
+ *  navigated with first_child() and next_sibling(), for example
+ *
+ *  @code
+ *  resp3::response_view resp;
+ *  co_await conn->async_exec(req, adapt(resp));
+ *
+ *  // Iterates over the elements of the aggregate at position 0.
+ *  for (auto i = resp.first_child(0), end = resp.next_sibling(0); i != end; i = resp.next_sibling(i))
+ *     std::cout << resp[i].value << std::endl;
+ *  @endcode
+ *
+ *  The nodes returned refer to memory owned by this object and
+ *  remain valid until it is modified or destroyed.
+ */
+class response_view {
+private:
+   struct entry {
+      type data_type;
+      std::size_t aggregate_size;
+      std::size_t depth;
+      std::size_t offset;
+      std::size_t size;
+
+      // Index past the subtree of this node, zero while the
+      // aggregate is still open.
+      std::size_t next;
+   };
+
+   // Deep enough for the nesting supported by the parser.
+   static constexpr std::size_t max_depth = 8;
+
+   std::vector<entry> entries_;
+   std::string data_;
+
+   // Aggregates whose subtree has not ended yet.
+   std::array<std::size_t, max_depth> open_{};
+   std::size_t open_size_ = 0;
+
+   void add(type t, std::size_t aggregate_size, std::size_t depth, std::size_t size)
+   {
+      auto const i = entries_.size();
+
+      // Pre-order: A node ends the subtrees of all open aggregates
+      // at the same or higher depth.
+      while (open_size_ != 0 && entries_[open_[open_size_ - 1]].depth >= depth)
+         entries_[open_[--open_size_]].next = i;
+
+      auto const open = is_aggregate(t) && aggregate_size != 0;
+      entries_.push_back({t, aggregate_size, depth, data_.size(), size, open ? 0 : i + 1});
+      if (open) {
+         BOOST_ASSERT(open_size_ < max_depth);
+         open_[open_size_++] = i;
+      }
+   }
+
+public:
+   /// The type of the nodes.
+   using value_type = node<boost::string_view>;
+
+   /// Random access iterator over the nodes in pre-order.
+   class const_iterator {
+   public:
+      using iterator_category = std::random_access_iterator_tag;
+      using value_type = response_view::value_type;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = value_type;
+
+      const_iterator() = default;
+
+      auto operator*() const -> value_type { return (*view_)[i_]; }
+      auto operator[](difference_type n) const -> value_type { return (*view_)[i_ + n]; }
+
+      auto operator++() -> const_iterator& { ++i_; return *this; }
+      auto operator++(int) -> const_iterator { auto tmp = *this; ++i_; return tmp; }
+      auto operator--() -> const_iterator& { --i_; return *this; }
+      auto operator--(int) -> const_iterator { auto tmp = *this; --i_; return tmp; }
+      auto operator+=(difference_type n) -> const_iterator& { i_ += n; return *this; }
+      auto operator-=(difference_type n) -> const_iterator& { i_ -= n; return *this; }
+
+      friend auto operator+(const_iterator it, difference_type n) { return it += n; }
+      friend auto operator+(difference_type n, const_iterator it) { return it += n; }
+      friend auto operator-(const_iterator it, difference_type n) { return it -= n; }
+      friend auto operator-(const_iterator a, const_iterator b) -> difference_type
+         { return static_cast<difference_type>(a.i_) - static_cast<difference_type>(b.i_); }
+
+      friend auto operator==(const_iterator a, const_iterator b) { return a.i_ == b.i_; }
+      friend auto operator!=(const_iterator a, const_iterator b) { return a.i_ != b.i_; }
+      friend auto operator<(const_iterator a, const_iterator b) { return a.i_ < b.i_; }
+      friend auto operator>(const_iterator a, const_iterator b) { return a.i_ > b.i_; }
+      friend auto operator<=(const_iterator a, const_iterator b) { return a.i_ <= b.i_; }
+      friend auto operator>=(const_iterator a, const_iterator b) { return a.i_ >= b.i_; }
+
+   private:
+      friend class response_view;
+
+      const_iterator(response_view const* view, std::size_t i) : view_{view}, i_{i} {}
+
+      response_view const* view_ = nullptr;
+      std::size_t i_ = 0;
+   };
+
+   /// Returns the number of nodes.
+   auto size() const noexcept { return entries_.size(); }
+
+   /// Returns true if there are no nodes.
+   auto empty() const noexcept { return entries_.empty(); }
+
+   /// Returns the node at position i.
+   auto operator[](std::size_t i) const noexcept -> value_type
+   {
+      BOOST_ASSERT(i < size());
+      auto const& e = entries_[i];
+      return {e.data_type, e.aggregate_size, e.depth, {data_.data() + e.offset, e.size}};
+   }
+
+   /// Returns the node at position i, throws if i is out of range.
+   auto at(std::size_t i) const -> value_type
+   {
+      if (i >= size())
+         BOOST_THROW_EXCEPTION(std::out_of_range{"aedis::resp3::response_view::at"});
+
+      return (*this)[i];
+   }
+
+   /// Returns an iterator to the first node.
+   auto begin() const noexcept { return const_iterator{this, 0}; }
+
+   /// Returns an iterator past the last node.
+   auto end() const noexcept { return const_iterator{this, size()}; }
+
+   /** \brief Returns the position of the node that follows the
+    *  subtree of the node at position i.
+    *
+    *  For an element of an aggregate this is its next sibling, or
+    *  the node that follows the aggregate if it is the last element.
+    *  Returns size() if there is none. The elements of an aggregate
+    *  at position p therefore end at next_sibling(p) rather than at
+    *  size().
+    */
+   auto next_sibling(std::size_t i) const noexcept -> std::size_t
+   {
+      BOOST_ASSERT(i < size());
+      auto const next = entries_[i].next;
+      return next == 0 ? size() : next;
+   }
+
+   /** \brief Returns the position of the first element of the
+    *  aggregate at position i, or next_sibling(i) if it has none.
+    */
+   auto first_child(std::size_t i) const noexcept -> std::size_t
+   {
+      BOOST_ASSERT(i < size());
+      return i + 1 < size() && entries_[i + 1].depth > entries_[i].depth ? i + 1 : next_sibling(i);
+   }
+
+   /// Reserves space for the given number of nodes and bytes of data.
+   void reserve(std::size_t nodes, std::size_t bytes)
+   {
+      entries_.reserve(nodes);
+      data_.reserve(bytes);
+   }
+
+   /// Removes all nodes, keeps the memory.
+   void clear() noexcept
+   {
+      entries_.clear();
+      data_.clear();
+      open_size_ = 0;
+   }
+
+   /// Appends a node, its value is copied.
+   void push_back(value_type const& nd)
+   {
+      add(nd.data_type, nd.aggregate_size, nd.depth, nd.value.size());
+      data_.append(nd.value.data(), nd.value.size());
+   }
+
+   /** \brief Appends a node whose value of the given size is written
+    *  by the caller.
+    *
+    *  @returns A pointer to the storage for the value, valid until
+    *  this object is modified.
+    */
+   auto push_back(value_type const& nd, std::size_t size) -> char*
+   {
+      add(nd.data_type, nd.aggregate_size, nd.depth, size);
+      auto const offset = data_.size();
+      data_.resize(offset + size);
+      return data_.data() + offset;
+   }
+};
+
+} // aedis::resp3
+
+#endif // AEDIS_RESP3_RESPONSE_VIEW_HPP
@@ -8,6 +8,10 @@
 #define AEDIS_RESP3_WRITE_HPP
 
 #include <boost/asio/write.hpp>
+#include <boost/system/system_error.hpp>
+#include <boost/throw_exception.hpp>
+
+#include <aedis/resp3/detail/write_ops.hpp>
 
 namespace aedis::resp3 {
 
@@ -23,7 +27,12 @@ template<
    >
 auto write(SyncWriteStream& stream, Request const& req)
 {
-   return boost::asio::write(stream, boost::asio::buffer(req.payload()));
+   boost::system::error_code ec;
+   auto const n = detail::write_payload(stream, req.payload(), req.segments(), ec);
+   if (ec)
+      BOOST_THROW_EXCEPTION(boost::system::system_error{ec});
+
+   return n;
 }
 
 template<
@@ -35,7 +44,7 @@ auto write(
     Request const& req,
     boost::system::error_code& ec)
 {
-   return boost::asio::write(stream, boost::asio::buffer(req.payload()), ec);
+   return detail::write_payload(stream, req.payload(), req.segments(), ec);
 }
 
 /** \brief Writes a request asynchronously.
@@ -56,7 +65,7 @@ auto async_write(
    CompletionToken&& token =
       boost::asio::default_completion_token_t<typename AsyncWriteStream::executor_type>{})
 {
-   return boost::asio::async_write(stream, boost::asio::buffer(req.payload()), token);
+   return detail::async_write_payload(stream, req.payload(), req.segments(), token);
 }
 
 } // aedis::resp3
@@ -51,6 +51,9 @@ public:
 
    using base_type = aedis::detail::connection_base<executor_type, basic_connection<boost::asio::ssl::stream<AsyncReadWriteStream>>>;
 
+   /// Connection configuration options.
+   using config = typename base_type::config;
+
    /// Constructor
    explicit
    basic_connection(
@@ -73,6 +76,12 @@ public:
    /// Returns the associated executor.
    auto get_executor() {return stream_.get_executor();}
 
+   /// Returns a reference to the config object.
+   auto get_config() noexcept -> config& { return base_type::get_config(); }
+
+   /// Returns a const reference to the config object.
+   auto get_config() const noexcept -> config const& { return base_type::get_config(); }
+
    /// Reset the underlying stream.
    void reset_stream(boost::asio::ssl::context& ctx)
    {
@@ -110,6 +119,21 @@ public:
       return base_type::async_exec(req, adapter, std::move(token));
    }
 
+   /** @brief Executes a shared request on the Redis server asynchronously.
+    *
+    *  See aedis::connection::async_exec for more information.
+    */
+   template <
+      class Adapter = aedis::detail::response_traits<void>::adapter_type,
+      class CompletionToken = boost::asio::default_completion_token_t<executor_type>>
+   auto async_exec(
+      std::shared_ptr<resp3::request const> req,
+      Adapter adapter = adapt(),
+      CompletionToken token = CompletionToken{})
+   {
+      return base_type::async_exec(std::move(req), adapter, std::move(token));
+   }
+
    /** @brief Receives server side pushes asynchronously.
     *
     *  See aedis::connection::async_receive for detailed information.
@@ -141,7 +165,6 @@ private:
    template <class> friend struct aedis::detail::run_op;
    template <class> friend struct aedis::detail::writer_op;
    template <class> friend struct aedis::detail::reader_op;
-   template <class, class> friend struct aedis::detail::exec_read_op;
 
    auto is_open() const noexcept { return stream_.next_layer().is_open(); }
    void close() { stream_.next_layer().close(); }
@@ -4,6 +4,7 @@
  * accompanying file LICENSE.txt)
  */
 
+#include <cstdio>
 #include <iostream>
 #include <boost/asio.hpp>
 #include <boost/system/errc.hpp>
@@ -107,3 +108,454 @@ BOOST_AUTO_TEST_CASE(request_retry)
 
    ioc.run();
 }
+
+BOOST_AUTO_TEST_CASE(shared_request)
+{
+   auto req = std::make_shared<request>();
+   req->push("PING", std::string(1000, 'a'));
+   std::weak_ptr<request const> const weak = req;
+
+   request quit;
+   quit.push("QUIT");
+
+   net::io_context ioc;
+   connection conn{ioc};
+
+   auto const endpoints = resolve();
+   net::connect(conn.next_layer(), endpoints);
+
+   std::vector<std::tuple<std::string>> resps(10);
+   for (auto& resp : resps) {
+      conn.async_exec(req, adapt(resp), [](auto ec, auto){
+         BOOST_TEST(!ec);
+      });
+   }
+
+   // The connection keeps the request alive.
+   req.reset();
+
+   conn.async_exec(quit, adapt(), [](auto ec, auto){
+      BOOST_TEST(!ec);
+   });
+
+   conn.async_run([](auto ec){
+      BOOST_TEST(!ec);
+   });
+
+   ioc.run();
+
+   BOOST_TEST(weak.expired());
+   for (auto const& resp : resps)
+      BOOST_CHECK_EQUAL(std::get<0>(resp), std::string(1000, 'a'));
+}
+
+#if !defined(_WIN32)
+BOOST_AUTO_TEST_CASE(file_argument)
+{
+   // Large enough not to be sent by a single sendfile call.
+   std::string const content = "header" + std::string(4000000, 'f');
+
+   auto* file = std::tmpfile();
+   BOOST_TEST_REQUIRE(file != nullptr);
+   BOOST_CHECK_EQUAL(std::fwrite(content.data(), 1, content.size(), file), content.size());
+   std::fflush(file);
+
+   request ping;
+   ping.push("PING");
+
+   request req;
+   req.push("SET", "file_argument", aedis::resp3::file_arg{fileno(file), 6, content.size() - 6});
+   req.push("GET", "file_argument");
+   req.push("QUIT");
+
+   net::io_context ioc;
+   connection conn{ioc};
+
+   auto const endpoints = resolve();
+   net::connect(conn.next_layer(), endpoints);
+
+   // Writing the file leaves the blocking mode of the socket as it
+   // was, so that synchronous writes by the user keep blocking.
+   std::tuple<aedis::ignore, std::string, aedis::ignore> resp;
+   conn.async_exec(ping, adapt(), [&](auto ec, auto){
+      BOOST_TEST(!ec);
+      auto const mode = conn.next_layer().native_non_blocking();
+      conn.async_exec(req, adapt(resp), [&, mode](auto ec, auto){
+         BOOST_TEST(!ec);
+         BOOST_CHECK_EQUAL(conn.next_layer().native_non_blocking(), mode);
+         BOOST_TEST(!conn.next_layer().non_blocking());
+      });
+   });
+
+   conn.async_run([](auto ec){
+      BOOST_TEST(!ec);
+   });
+
+   ioc.run();
+   std::fclose(file);
+
+   BOOST_TEST(std::get<1>(resp) == content.substr(6));
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(split_range)
+{
+   std::vector<std::pair<std::string, std::string>> kv;
+   std::vector<std::string> keys;
+   for (auto i = 0; i < 5; ++i) {
+      keys.push_back("split_range_" + std::to_string(i));
+      kv.push_back({keys.back(), std::to_string(i)});
+   }
+
+   request req;
+   req.get_config().max_range_size = 2;
+   req.push_range("MSET", kv);
+   req.push_range("MGET", keys);
+   req.push_range("MGET", keys);
+   req.push_range("DEL", keys);
+   req.push("QUIT");
+   BOOST_CHECK_EQUAL(req.responses(), 5UL);
+
+   net::io_context ioc;
+   connection conn{ioc};
+
+   auto const endpoints = resolve();
+   net::connect(conn.next_layer(), endpoints);
+
+   std::tuple<
+      std::string,
+      std::array<std::string, 5>,
+      std::vector<aedis::resp3::node<std::string>>,
+      int,
+      aedis::ignore> resp;
+
+   conn.async_exec(req, adapt(resp), [](auto ec, auto){
+      BOOST_TEST(!ec);
+   });
+
+   conn.async_run([](auto ec){
+      BOOST_TEST(!ec);
+   });
+
+   ioc.run();
+
+   BOOST_CHECK_EQUAL(std::get<0>(resp), "OK");
+   for (auto i = 0; i < 5; ++i)
+      BOOST_CHECK_EQUAL(std::get<1>(resp)[i], std::to_string(i));
+
+   // The merged aggregate has the size of the whole range.
+   auto const& nodes = std::get<2>(resp);
+   BOOST_REQUIRE_EQUAL(nodes.size(), 6UL);
+   BOOST_CHECK_EQUAL(nodes.front().aggregate_size, 5UL);
+   for (auto i = 0; i < 5; ++i)
+      BOOST_CHECK_EQUAL(nodes[i + 1].value, std::to_string(i));
+
+   BOOST_CHECK_EQUAL(std::get<3>(resp), 5);
+}
+
+BOOST_AUTO_TEST_CASE(empty_request)
+{
+   request empty;
+
+   request quit;
+   quit.push("QUIT");
+
+   net::io_context ioc;
+   connection conn{ioc};
+
+   auto const endpoints = resolve();
+   net::connect(conn.next_layer(), endpoints);
+
+   conn.async_run([](auto ec){
+      BOOST_TEST(!ec);
+   });
+
+   // Executed while the writer is idle.
+   bool done = false;
+   conn.async_exec(empty, adapt(), [&](auto ec, auto n){
+      BOOST_TEST(!ec);
+      BOOST_CHECK_EQUAL(n, 0UL);
+      done = true;
+
+      conn.async_exec(quit, adapt(), [](auto ec, auto){
+         BOOST_TEST(!ec);
+      });
+   });
+
+   ioc.run();
+   BOOST_TEST(done);
+}
+
+void test_max_in_flight(std::size_t max_in_flight)
+{
+   request req;
+   req.push("PING", "pipelined");
+
+   request quit;
+   quit.push("QUIT");
+
+   net::io_context ioc;
+   connection conn{ioc};
+   conn.get_config().max_in_flight = max_in_flight;
+
+   auto const endpoints = resolve();
+   net::connect(conn.next_layer(), endpoints);
+
+   std::vector<std::tuple<std::string>> resps(10);
+   for (auto& resp : resps) {
+      conn.async_exec(req, adapt(resp), [](auto ec, auto){
+         BOOST_TEST(!ec);
+      });
+   }
+
+   conn.async_exec(quit, adapt(), [](auto ec, auto){
+      BOOST_TEST(!ec);
+   });
+
+   conn.async_run([](auto ec){
+      BOOST_TEST(!ec);
+   });
+
+   ioc.run();
+
+   for (auto const& resp : resps)
+      BOOST_CHECK_EQUAL(std::get<0>(resp), "pipelined");
+}
+
+BOOST_AUTO_TEST_CASE(max_in_flight)
+{
+   test_max_in_flight(1);
+   test_max_in_flight(3);
+   test_max_in_flight((std::numeric_limits<std::size_t>::max)());
+}
+
+// Records what the connection writes.
+struct recording_socket : net::ip::tcp::socket {
+   using net::ip::tcp::socket::socket;
+
+   template <class ConstBufferSequence, class WriteHandler>
+   auto async_write_some(ConstBufferSequence const& buffers, WriteHandler&& handler)
+   {
+      for (auto it = net::buffer_sequence_begin(buffers); it != net::buffer_sequence_end(buffers); ++it) {
+         net::const_buffer const b = *it;
+         written.append(static_cast<char const*>(b.data()), b.size());
+      }
+
+      ++writes;
+      return net::ip::tcp::socket::async_write_some(buffers, std::forward<WriteHandler>(handler));
+   }
+
+   std::string written;
+   std::size_t writes = 0;
+};
+
+// The second request is executed while the response to the first is
+// pending and is written before it arrives only if max_in_flight
+// allows.
+void test_max_in_flight_pending(std::size_t max_in_flight, bool written)
+{
+   request req1;
+   req1.push("PING", "first");
+
+   request req2;
+   req2.push("PING", "second");
+   req2.push("QUIT");
+
+   net::io_context ioc;
+   aedis::basic_connection<recording_socket> conn{ioc};
+   conn.get_config().max_in_flight = max_in_flight;
+
+   auto const endpoints = resolve();
+   net::connect(conn.next_layer(), endpoints);
+
+   std::tuple<std::string> resp1;
+   conn.async_exec(req1, adapt(resp1), [&](auto ec, auto){
+      BOOST_TEST(!ec);
+      auto const& w = conn.next_layer().written;
+      BOOST_CHECK_EQUAL(w.find("second") != std::string::npos, written);
+   });
+
+   conn.async_run([](auto ec){
+      BOOST_TEST(!ec);
+   });
+
+   // The first request is being written.
+   BOOST_TEST(conn.next_layer().written.find("first") != std::string::npos);
+
+   std::tuple<std::string, aedis::ignore> resp2;
+   conn.async_exec(req2, adapt(resp2), [](auto ec, auto){
+      BOOST_TEST(!ec);
+   });
+
+   ioc.run();
+
+   BOOST_CHECK_EQUAL(std::get<0>(resp1), "first");
+   BOOST_CHECK_EQUAL(std::get<0>(resp2), "second");
+}
+
+BOOST_AUTO_TEST_CASE(max_in_flight_pending)
+{
+   test_max_in_flight_pending(1, false);
+   test_max_in_flight_pending(2, true);
+   test_max_in_flight_pending((std::numeric_limits<std::size_t>::max)(), true);
+}
+
+// Requests that are executed while a batch is being written go out
+// in the next one.
+void exec_chain(connection& conn, request const& req, request const& quit, std::tuple<std::string>& resp, int n, int& chains)
+{
+   if (n == 0) {
+      if (--chains == 0) {
+         conn.async_exec(quit, adapt(), [](auto ec, auto){
+            BOOST_TEST(!ec);
+         });
+      }
+      return;
+   }
+
+   conn.async_exec(req, adapt(resp), [&, n](auto ec, auto){
+      BOOST_TEST(!ec);
+      BOOST_CHECK_EQUAL(std::get<0>(resp), "chained");
+      std::get<0>(resp).clear();
+      exec_chain(conn, req, quit, resp, n - 1, chains);
+   });
+}
+
+BOOST_AUTO_TEST_CASE(exec_while_writing)
+{
+   request req;
+   req.push("PING", "chained");
+
+   request quit;
+   quit.push("QUIT");
+
+   net::io_context ioc;
+   connection conn{ioc};
+
+   auto const endpoints = resolve();
+   net::connect(conn.next_layer(), endpoints);
+
+   int chains = 10;
+   std::vector<std::tuple<std::string>> resps(chains);
+   for (auto& resp : resps)
+      exec_chain(conn, req, quit, resp, 20, chains);
+
+   conn.async_run([](auto ec){
+      BOOST_TEST(!ec);
+   });
+
+   ioc.run();
+   BOOST_CHECK_EQUAL(chains, 0);
+}
+
+void test_write_delay(connection::config const& cfg)
+{
+   request req;
+   req.push("PING", "delayed");
+
+   request quit;
+   quit.push("QUIT");
+
+   net::io_context ioc;
+   connection conn{ioc};
+   conn.get_config() = cfg;
+
+   auto const endpoints = resolve();
+   net::connect(conn.next_layer(), endpoints);
+
+   std::vector<std::tuple<std::string>> resps(10);
+   for (auto& resp : resps) {
+      conn.async_exec(req, adapt(resp), [](auto ec, auto){
+         BOOST_TEST(!ec);
+      });
+   }
+
+   conn.async_exec(quit, adapt(), [](auto ec, auto){
+      BOOST_TEST(!ec);
+   });
+
+   conn.async_run([](auto ec){
+      BOOST_TEST(!ec);
+   });
+
+   ioc.run();
+
+   for (auto const& resp : resps)
+      BOOST_CHECK_EQUAL(std::get<0>(resp), "delayed");
+}
+
+BOOST_AUTO_TEST_CASE(write_delay)
+{
+   connection::config cfg;
+   cfg.max_write_delay = std::chrono::milliseconds{1};
+   test_write_delay(cfg);
+
+   // Full batches are written without waiting.
+   cfg.max_write_delay = std::chrono::hours{1};
+   cfg.max_batch_commands = 1;
+   test_write_delay(cfg);
+
+   cfg.max_batch_commands = (std::numeric_limits<std::size_t>::max)();
+   cfg.max_batch_bytes = 1;
+   test_write_delay(cfg);
+
+   cfg.max_write_delay = std::chrono::milliseconds{1};
+   cfg.max_batch_bytes = (std::numeric_limits<std::size_t>::max)();
+   cfg.adaptive_write_delay = true;
+   test_write_delay(cfg);
+}
+
+using recording_connection = aedis::basic_connection<recording_socket>;
+
+// Executes the requests one after the other, letting the writer run
+// in between.
+void exec_burst(recording_connection& conn, request const& req, request const& quit, std::vector<std::tuple<std::string>>& resps, std::size_t i)
+{
+   if (i == resps.size()) {
+      conn.async_exec(quit, adapt(), [](auto ec, auto){
+         BOOST_TEST(!ec);
+      });
+      return;
+   }
+
+   conn.async_exec(req, adapt(resps.at(i)), [](auto ec, auto){
+      BOOST_TEST(!ec);
+   });
+
+   net::post(conn.get_executor(), [&, i]() {
+      exec_burst(conn, req, quit, resps, i + 1);
+   });
+}
+
+// A burst of requests right after the connection starts is written
+// in a single batch when the write delay is adaptive.
+BOOST_AUTO_TEST_CASE(adaptive_write_delay_burst)
+{
+   request req;
+   req.push("PING", "burst");
+
+   request quit;
+   quit.push("QUIT");
+
+   net::io_context ioc;
+   recording_connection conn{ioc};
+   conn.get_config().max_write_delay = std::chrono::milliseconds{100};
+   conn.get_config().adaptive_write_delay = true;
+
+   auto const endpoints = resolve();
+   net::connect(conn.next_layer(), endpoints);
+
+   conn.async_run([](auto ec){
+      BOOST_TEST(!ec);
+   });
+
+   std::vector<std::tuple<std::string>> resps(10);
+   exec_burst(conn, req, quit, resps, 0);
+
+   ioc.run();
+
+   for (auto const& resp : resps)
+      BOOST_CHECK_EQUAL(std::get<0>(resp), "burst");
+
+   BOOST_CHECK_EQUAL(conn.next_layer().writes, 1u);
+}
@@ -5,6 +5,7 @@
  */
 
 #include <map>
+#include <cstring>
 #include <iostream>
 #include <optional>
 #include <sstream>
@@ -21,6 +22,7 @@
 
 #include <aedis.hpp>
 #include <aedis/src.hpp>
+#include <aedis/detail/intrusive_list.hpp>
 
 // TODO: Test with empty strings.
 
@@ -179,6 +181,8 @@ std::vector<node_type> streamed_string_e2 { {resp3::type::streamed_string_part,
    test(ex, make_expected(S07, std::string{}, "streamed_string.error", aedis::error::not_a_number)); \
    test(ex, make_expected(S08, std::tuple<int>{11}, "number.tuple.int")); \
    test(ex, make_expected(S09, node_type{resp3::type::number, 1UL, 0UL, {"-3"}}, "number.node (negative)")); \
+   test(ex, make_expected(S09, int{-3}, "number.int (negative)")); \
+   test(ex, make_expected(S09, std::size_t{}, "number.size_t.error (negative)", aedis::error::not_a_number)); \
    test(ex, make_expected(S10, int{11}, "number.int")); \
    test(ex, make_expected(S10, op_int_ok, "number.optional.int")); \
    test(ex, make_expected(S10, std::list<std::string>{}, "number.optional.int", aedis::error::expects_resp3_aggregate)); \
@@ -556,6 +560,213 @@ BOOST_AUTO_TEST_CASE(test_blob_string)
    ioc.run();
 }
 
+// Bulks that are large enough are written directly into the
+// response.
+BOOST_AUTO_TEST_CASE(test_bulk_storage)
+{
+   net::io_context ioc;
+   std::string str(100000, 'a');
+   str[1000] = '\r';
+   str[1001] = '\n';
+
+   auto const blob = "$" + std::to_string(str.size()) + "\r\n" + str + "\r\n";
+
+   auto const in01 = expect<std::string>{blob, str, "bulk_storage.string"};
+   auto const in02 = expect<std::optional<std::string>>{blob, str, "bulk_storage.optional"};
+   auto const in03 = expect<std::vector<std::string>>{"*3\r\n" + blob + "$2\r\nab\r\n" + blob, {str, "ab", str}, "bulk_storage.vector"};
+   auto const in04 = expect<std::list<std::string>>{"*2\r\n" + blob + blob, {str, str}, "bulk_storage.list"};
+   auto const in05 = expect<vec_node_type>{"*2\r\n" + blob + ":1\r\n", {{resp3::type::array, 2UL, 0UL, {}}, {resp3::type::blob_string, 1UL, 1UL, str}, {resp3::type::number, 1UL, 1UL, "1"}}, "bulk_storage.node"};
+   auto const in06 = expect<std::tuple<std::string, int>>{"*2\r\n" + blob + ":1\r\n", {str, 1}, "bulk_storage.tuple"};
+
+   auto ex = ioc.get_executor();
+
+   test_sync(ex, in01);
+   test_sync(ex, in02);
+   test_sync(ex, in03);
+   test_sync(ex, in04);
+   test_sync(ex, in05);
+   test_sync(ex, in06);
+
+   test_async(ex, in01);
+   test_async(ex, in02);
+   test_async(ex, in03);
+   test_async(ex, in04);
+   test_async(ex, in05);
+   test_async(ex, in06);
+   ioc.run();
+}
+
+BOOST_AUTO_TEST_CASE(bulk_storage_bounded_buffer)
+{
+   net::io_context ioc;
+   boost::system::error_code ec;
+
+   std::string const large(1000000, 'a');
+   test_stream ts {ioc};
+   ts.append("$" + std::to_string(large.size()) + "\r\n" + large + "\r\n:1\r\n");
+
+   // The buffer never has to hold the payload.
+   resp3::read_buffer rbuffer;
+   std::string value;
+   resp3::read(ts, resp3::dynamic_buffer(rbuffer, 8192), adapt2(value), ec);
+   BOOST_TEST(!ec);
+   BOOST_TEST(value == large);
+
+   int i = 0;
+   resp3::read(ts, resp3::dynamic_buffer(rbuffer, 8192), adapt2(i), ec);
+   BOOST_TEST(!ec);
+   BOOST_CHECK_EQUAL(i, 1);
+}
+
+BOOST_AUTO_TEST_CASE(sink_chunks)
+{
+   net::io_context ioc;
+   boost::system::error_code ec;
+
+   std::string const large(1000000, 'a');
+   test_stream ts {ioc};
+   ts.append("*3\r\n$" + std::to_string(large.size()) + "\r\n" + large + "\r\n:1\r\n$?\r\n;2\r\nab\r\n;1\r\nc\r\n;0\r\n");
+
+   std::vector<std::string> values(1);
+   std::size_t chunks = 0;
+   auto s = aedis::make_sink([&](boost::string_view chunk, bool last, boost::system::error_code&) {
+      values.back().append(chunk.data(), chunk.size());
+      ++chunks;
+      if (last)
+         values.emplace_back();
+   });
+
+   // The buffer never has to hold the large value.
+   resp3::read_buffer rbuffer;
+   resp3::read(ts, resp3::dynamic_buffer(rbuffer, 8192), adapt2(s), ec);
+   BOOST_TEST(!ec);
+   BOOST_CHECK_EQUAL(values.size(), 4UL);
+   BOOST_TEST(values.at(0) == large);
+   BOOST_CHECK_EQUAL(values.at(1), "1");
+   BOOST_CHECK_EQUAL(values.at(2), "abc");
+   BOOST_TEST(chunks > values.size());
+}
+
+BOOST_AUTO_TEST_CASE(sink_error)
+{
+   net::io_context ioc;
+   boost::system::error_code ec;
+
+   std::string const large(100000, 'a');
+   test_stream ts {ioc};
+   ts.append("$" + std::to_string(large.size()) + "\r\n" + large + "\r\n");
+
+   auto s = aedis::make_sink([&](boost::string_view, bool, boost::system::error_code& ec) {
+      ec = aedis::error::incompatible_size;
+   });
+
+   resp3::read_buffer rbuffer;
+   resp3::read(ts, resp3::dynamic_buffer(rbuffer), adapt2(s), ec);
+   BOOST_CHECK_EQUAL(ec, aedis::error::incompatible_size);
+}
+
+BOOST_AUTO_TEST_CASE(test_response_view)
+{
+   net::io_context ioc;
+   std::string const large(10000, 'a');
+   std::string const wire = "*3\r\n%2\r\n$4\r\nkey1\r\n*2\r\n:1\r\n:2\r\n$4\r\nkey2\r\n_\r\n$" + std::to_string(large.size()) + "\r\n" + large + "\r\n*0\r\n";
+
+   test_stream ts {ioc};
+   ts.append(wire);
+   ts.append(wire);
+   ts.append("+OK\r\n");
+
+   resp3::read_buffer rbuffer;
+   vec_node_type nodes;
+   resp3::read(ts, resp3::dynamic_buffer(rbuffer), adapt2(nodes));
+
+   // Two responses in the same view.
+   resp3::response_view view;
+   resp3::read(ts, resp3::dynamic_buffer(rbuffer), adapt2(view));
+   resp3::read(ts, resp3::dynamic_buffer(rbuffer), adapt2(view));
+
+   BOOST_CHECK_EQUAL(view.size(), nodes.size() + 1);
+   for (std::size_t i = 0; i < nodes.size(); ++i) {
+      auto const nd = view[i];
+      auto const expected = node_type{nd.data_type, nd.aggregate_size, nd.depth, std::string{nd.value}};
+      BOOST_CHECK_EQUAL(expected, nodes.at(i));
+   }
+
+   BOOST_TEST(std::equal(nodes.begin(), nodes.end(), view.begin(), [](auto const& a, auto const& b) { return a.value == b.value; }));
+
+   // The elements of the first response.
+   std::vector<resp3::type> children;
+   for (auto i = view.first_child(0), end = view.next_sibling(0); i != end; i = view.next_sibling(i))
+      children.push_back(view[i].data_type);
+
+   BOOST_TEST((children == std::vector<resp3::type>{resp3::type::map, resp3::type::blob_string, resp3::type::array}));
+
+   // The values of the map.
+   auto const key2 = view.next_sibling(view.next_sibling(view.first_child(1)));
+   BOOST_CHECK_EQUAL(view[key2].value, "key2");
+   BOOST_CHECK_EQUAL(view[view.next_sibling(key2)].data_type, resp3::type::null);
+   BOOST_TEST(view[view.next_sibling(1)].value == large);
+
+   // Empty aggregates have no children.
+   auto const empty = view.size() - 2;
+   BOOST_CHECK_EQUAL(view.first_child(empty), view.next_sibling(empty));
+   BOOST_CHECK_EQUAL(view.next_sibling(empty), view.size() - 1);
+   BOOST_CHECK_EQUAL(view.at(view.size() - 1).value, "OK");
+   BOOST_CHECK_THROW(view.at(view.size()), std::out_of_range);
+}
+
+// A single response whose last node closes the aggregates, so that
+// the loops end at size().
+BOOST_AUTO_TEST_CASE(test_response_view_single)
+{
+   net::io_context ioc;
+   test_stream ts {ioc};
+   ts.append("*3\r\n:1\r\n*2\r\n$1\r\na\r\n$1\r\nb\r\n*2\r\n:2\r\n:3\r\n");
+
+   resp3::read_buffer rbuffer;
+   resp3::response_view view;
+   resp3::read(ts, resp3::dynamic_buffer(rbuffer), adapt2(view));
+   BOOST_CHECK_EQUAL(view.size(), 8u);
+
+   std::vector<std::size_t> children;
+   for (auto i = view.first_child(0), end = view.next_sibling(0); i != end; i = view.next_sibling(i))
+      children.push_back(i);
+
+   BOOST_TEST((children == std::vector<std::size_t>{1, 2, 5}));
+   BOOST_CHECK_EQUAL(view.next_sibling(0), view.size());
+
+   // The elements of the nested aggregates.
+   std::string values;
+   for (auto p : {children.at(1), children.at(2)})
+      for (auto i = view.first_child(p), end = view.next_sibling(p); i != end; i = view.next_sibling(i))
+         values.append(view[i].value.data(), view[i].value.size());
+
+   BOOST_CHECK_EQUAL(values, "ab23");
+}
+
+// Lines of all lengths, so that they end at every position of the
+// blocks scanned for line ends, with a lone LF and CR in them.
+BOOST_AUTO_TEST_CASE(test_line_lengths)
+{
+   net::io_context ioc;
+
+   std::vector<std::string> expected;
+   std::string wire = "*200\r\n";
+   for (std::size_t i = 0; i < 200; ++i) {
+      std::string e(i, 'a');
+      if (i > 2) {
+         e[i / 2] = '\n';
+         e[i - 1] = '\r';
+      }
+
+      wire += "+" + e + "\r\n";
+      expected.push_back(e);
+   }
+
+   auto ex = ioc.get_executor();
+   test_sync(ex, expect<std::vector<std::string>>{wire, expected, "line_lengths"});
+}
+
 BOOST_AUTO_TEST_CASE(test_double)
 {
    net::io_context ioc;
@@ -564,6 +775,10 @@ BOOST_AUTO_TEST_CASE(test_double)
    auto const in03 = expect<node_type>{",-inf\r\n", node_type{resp3::type::doublean, 1UL, 0UL, {"-inf"}}, "double.node (-inf)"};
    auto const in04 = expect<double>{",1.23\r\n", double{1.23}, "double.double"};
    auto const in05 = expect<double>{",er\r\n", double{0}, "double.double", aedis::error::not_a_double};
+   auto const in06 = expect<double>{",-inf\r\n", -std::numeric_limits<double>::infinity(), "double.double (-inf)"};
+   auto const in07 = expect<double>{",-1.5e3\r\n", double{-1500}, "double.double (exponent)"};
+   auto const in08 = expect<double>{",0.30000000000000004441\r\n", double{0.30000000000000004441}, "double.double (long)"};
+   auto const in09 = expect<double>{",1.5x\r\n", double{0}, "double.double", aedis::error::not_a_double};
 
    auto ex = ioc.get_executor();
 
@@ -572,12 +787,20 @@ BOOST_AUTO_TEST_CASE(test_double)
    test_sync(ex, in03);
    test_sync(ex, in04);
    test_sync(ex, in05);
+   test_sync(ex, in06);
+   test_sync(ex, in07);
+   test_sync(ex, in08);
+   test_sync(ex, in09);
 
    test_async(ex, in01);
    test_async(ex, in02);
    test_async(ex, in03);
    test_async(ex, in04);
    test_async(ex, in05);
+   test_async(ex, in06);
+   test_async(ex, in07);
+   test_async(ex, in08);
+   test_async(ex, in09);
    ioc.run();
 }
 
@@ -784,6 +1007,291 @@ BOOST_AUTO_TEST_CASE(ignore_adapter_no_error)
    BOOST_TEST(rbuffer.empty());
 }
 
+BOOST_AUTO_TEST_CASE(ignore_adapter_skips_content)
+{
+   net::io_context ioc;
+   boost::system::error_code ec;
+
+   // The ignored bulk is larger than the buffer may grow to.
+   std::string const large(100000, 'a');
+   test_stream ts {ioc};
+   ts.append("*3\r\n$" + std::to_string(large.size()) + "\r\n" + large + "\r\n-Nested\r\n%1\r\n+a\r\n:1\r\n");
+   ts.append("$5\r\nhello\r\n");
+
+   resp3::read_buffer rbuffer;
+   resp3::read(ts, resp3::dynamic_buffer(rbuffer, 8192), adapt2(), ec);
+   BOOST_TEST(!ec);
+
+   std::string value;
+   resp3::read(ts, resp3::dynamic_buffer(rbuffer, 8192), adapt2(value), ec);
+   BOOST_TEST(!ec);
+   BOOST_CHECK_EQUAL(value, "hello");
+   BOOST_TEST(rbuffer.empty());
+}
+
+struct typed_adapter {
+   std::vector<std::string>* events;
+
+   void operator()(resp3::node<boost::string_view> const& nd, boost::system::error_code&)
+      { events->push_back("text:" + std::string{nd.value}); }
+
+   void operator()(resp3::node<boost::string_view> const&, std::int64_t v, boost::system::error_code&)
+      { events->push_back("int:" + std::to_string(v)); }
+
+   void operator()(resp3::node<boost::string_view> const&, double v, boost::system::error_code&)
+      { events->push_back("double:" + std::to_string(v)); }
+
+   void operator()(resp3::node<boost::string_view> const&, bool v, boost::system::error_code&)
+      { events->push_back(v ? "bool:true" : "bool:false"); }
+};
+
+BOOST_AUTO_TEST_CASE(typed_scalars)
+{
+   net::io_context ioc;
+   std::string rbuffer;
+   boost::system::error_code ec;
+
+   test_stream ts {ioc};
+   ts.append("*5\r\n:-3\r\n,1.5\r\n#t\r\n(12345678901234567890123\r\n$2\r\nab\r\n");
+
+   std::vector<std::string> events;
+   resp3::read(ts, net::dynamic_buffer(rbuffer), typed_adapter{&events}, ec);
+   BOOST_TEST(!ec);
+
+   std::vector<std::string> const expected
+   { "text:", "int:-3", "double:1.500000", "bool:true"
+   , "text:12345678901234567890123", "text:ab"};
+   BOOST_TEST(events == expected, boost::test_tools::per_element());
+
+   std::uint8_t small = 0;
+   ts.append(":300\r\n");
+   resp3::read(ts, net::dynamic_buffer(rbuffer), adapt2(small), ec);
+   BOOST_CHECK_EQUAL(ec, aedis::error::not_a_number);
+}
+
+BOOST_AUTO_TEST_CASE(read_buffer_pipeline)
+{
+   net::io_context ioc;
+   resp3::read_buffer rbuffer;
+   boost::system::error_code ec;
+
+   test_stream ts {ioc};
+   ts.append(":1\r\n$5\r\nhello\r\n:3\r\n");
+
+   int i1 = 0, i3 = 0;
+   std::string s2;
+   resp3::read(ts, resp3::dynamic_buffer(rbuffer), adapt2(i1), ec);
+   BOOST_TEST(!ec);
+   resp3::read(ts, resp3::dynamic_buffer(rbuffer), adapt2(s2), ec);
+   BOOST_TEST(!ec);
+   resp3::read(ts, resp3::dynamic_buffer(rbuffer), adapt2(i3), ec);
+   BOOST_TEST(!ec);
+
+   BOOST_CHECK_EQUAL(i1, 1);
+   BOOST_CHECK_EQUAL(s2, "hello");
+   BOOST_CHECK_EQUAL(i3, 3);
+   BOOST_TEST(rbuffer.empty());
+}
+
+BOOST_AUTO_TEST_CASE(read_buffer_compaction)
+{
+   resp3::read_buffer buf;
+   std::memcpy(buf.grow(8), "abcdefgh", 8);
+   buf.consume(5);
+   BOOST_CHECK_EQUAL(std::string(buf.data(), buf.size()), "fgh");
+
+   // Forces the buffer to grow while most of it has been consumed.
+   auto const n = buf.capacity() - buf.size() + 1;
+   std::memset(buf.grow(n), 'x', n);
+   BOOST_CHECK_EQUAL(buf.size(), 3 + n);
+   BOOST_CHECK_EQUAL(std::string(buf.data(), 3), "fgh");
+
+   buf.consume(buf.size());
+   BOOST_TEST(buf.empty());
+   BOOST_TEST(buf.capacity() >= 3 + n);
+}
+
+// Counts the calls to read_some.
+class counting_stream {
+public:
+   explicit counting_stream(test_stream& ts) : ts_{ts} {}
+
+   template <class MutableBufferSequence>
+   auto read_some(MutableBufferSequence const& buffers, boost::system::error_code& ec)
+   {
+      ++reads;
+      return ts_.read_some(buffers, ec);
+   }
+
+   template <class MutableBufferSequence>
+   auto read_some(MutableBufferSequence const& buffers)
+   {
+      ++reads;
+      return ts_.read_some(buffers);
+   }
+
+   int reads = 0;
+
+private:
+   test_stream& ts_;
+};
+
+BOOST_AUTO_TEST_CASE(reader_pipeline)
+{
+   net::io_context ioc;
+   test_stream ts {ioc};
+   ts.append("%1\r\n$6\r\nserver\r\n$5\r\nredis\r\n+PONG\r\n$5\r\nvalue\r\n:3\r\n+OK\r\n");
+
+   counting_stream cs{ts};
+   resp3::reader<counting_stream> reader{cs};
+
+   // One response.
+   reader.read();
+
+   // Many responses in the same adapter.
+   resp3::response_view resp;
+   boost::system::error_code ec;
+   reader.read(2, adapt2(resp), ec);
+   BOOST_TEST(!ec);
+   BOOST_CHECK_EQUAL(resp.size(), 2UL);
+   BOOST_CHECK_EQUAL(resp[0].value, "PONG");
+   BOOST_CHECK_EQUAL(resp[1].value, "value");
+
+   int i = 0;
+   reader.read(adapt2(i));
+   BOOST_CHECK_EQUAL(i, 3);
+
+   reader.read(1);
+   BOOST_TEST(reader.buffer().empty());
+
+   // All responses arrived in the same read.
+   BOOST_CHECK_EQUAL(cs.reads, 1);
+
+   // Nothing else to read.
+   ts.close_remote();
+   reader.read(adapt2(), ec);
+   BOOST_CHECK_EQUAL(ec, net::error::eof);
+}
+
+BOOST_AUTO_TEST_CASE(write_batch)
+{
+   std::string const value(1000, 'v');
+
+   resp3::request req1;
+   req1.push("SET", "key", resp3::borrow(value));
+
+   resp3::request req2;
+   req2.push("PING");
+
+   resp3::request empty;
+
+   resp3::request expected;
+   expected.push("SET", "key", value);
+   expected.push("PING");
+
+   resp3::detail::write_batch batch{std::pmr::get_default_resource()};
+   batch.add(req1);
+   batch.add(empty);
+   batch.add(req2);
+
+   // The payloads are not copied.
+   BOOST_CHECK_EQUAL(batch.buffers().size(), 4UL);
+   BOOST_TEST(batch.buffers()[1].data() == value.data());
+   BOOST_TEST(batch.buffers()[3].data() == req2.payload().data());
+
+   net::io_context ioc;
+   test_stream ts {ioc};
+   test_stream remote {ioc};
+   ts.connect(remote);
+
+   resp3::detail::async_write_batch(ts, batch, [&](auto ec, auto n) {
+      BOOST_TEST(!ec);
+      BOOST_CHECK_EQUAL(n, expected.payload().size());
+   });
+
+   ioc.run();
+   BOOST_CHECK_EQUAL(remote.str(), std::string(expected.payload()));
+
+   batch.clear();
+   BOOST_TEST(batch.empty());
+}
+
+struct list_node : aedis::detail::intrusive_list_hook<list_node> {
+   int value = 0;
+};
+
+BOOST_AUTO_TEST_CASE(intrusive_list)
+{
+   list_node nodes[4];
+   for (int i = 0; i < 4; ++i)
+      nodes[i].value = i;
+
+   aedis::detail::intrusive_list<list_node> list;
+   BOOST_TEST(list.empty());
+   BOOST_TEST(list.prev(nullptr) == nullptr);
+
+   list.push_back(&nodes[1]);
+   list.push_back(&nodes[3]);
+   list.insert(list.front(), &nodes[0]);
+   list.insert(&nodes[3], &nodes[2]);
+
+   std::vector<int> values;
+   for (auto* p = list.front(); p != nullptr; p = list.next(p))
+      values.push_back(p->value);
+
+   BOOST_TEST(values == (std::vector<int>{0, 1, 2, 3}), boost::test_tools::per_element());
+   BOOST_CHECK_EQUAL(list.size(), 4UL);
+   BOOST_TEST(list.back() == &nodes[3]);
+   BOOST_TEST(list.prev(nullptr) == &nodes[3]);
+   BOOST_TEST(list.prev(&nodes[2]) == &nodes[1]);
+
+   BOOST_TEST(list.erase(&nodes[1]) == &nodes[2]);
+   BOOST_TEST(!nodes[1].is_linked());
+   BOOST_TEST(list.prev(&nodes[2]) == &nodes[0]);
+
+   list.pop_front();
+   BOOST_TEST(list.front() == &nodes[2]);
+   BOOST_TEST(list.erase(&nodes[3]) == nullptr);
+   BOOST_TEST(list.back() == &nodes[2]);
+
+   list.pop_front();
+   BOOST_TEST(list.empty());
+   BOOST_TEST(list.back() == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(request_adapter)
+{
+   std::vector<std::string> const in{"a", "b", "c", "d", "e"};
+
+   resp3::request req;
+   req.get_config().max_range_size = 2;
+   req.push_range("SADD", "key", in);
+   req.push_range("RPUSH", in);
+   req.push("PING");
+
+   std::string const responses = ":2\r\n:1\r\n:1\r\n:2\r\n:4\r\n:5\r\n+PONG\r\n";
+
+   std::tuple<int, int, std::string> resp;
+   aedis::detail::request_adapter adapter;
+   adapter.emplace(aedis::adapt(resp));
+
+   boost::system::error_code ec;
+   std::size_t consumed = 0;
+   while (adapter.get_parsed_commands() != req.size()) {
+      resp3::detail::parser<aedis::detail::any_adapter> p{adapter.next(req)};
+      consumed += resp3::detail::consume_available(p, responses.data() + consumed, responses.size() - consumed, ec);
+      BOOST_TEST(!ec);
+      BOOST_TEST(p.done());
+      adapter.commit();
+   }
+
+   BOOST_CHECK_EQUAL(consumed, responses.size());
+   BOOST_CHECK_EQUAL(std::get<0>(resp), 4);
+   BOOST_CHECK_EQUAL(std::get<1>(resp), 5);
+   BOOST_CHECK_EQUAL(std::get<2>(resp), "PONG");
+   adapter.reset();
+}
+
 BOOST_AUTO_TEST_CASE(all_tests)
 {
    net::io_context ioc;
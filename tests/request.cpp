@@ -4,7 +4,10 @@
  * accompanying file LICENSE.txt)
  */
 
+#include <cstdio>
 #include <iostream>
+#include <limits>
+#include <vector>
 #include <memory_resource>
 
 #define BOOST_TEST_MODULE low level
@@ -55,3 +58,290 @@ BOOST_AUTO_TEST_CASE(container_and_range)
    req2.push_range("HSET", "key", std::cbegin(in), std::cend(in));
    BOOST_CHECK_EQUAL(req2.payload(), std::pmr::string{res});
 }
+
+BOOST_AUTO_TEST_CASE(arg_integers)
+{
+   char const* res = "*5\r\n$4\r\nPING\r\n$3\r\n-42\r\n$1\r\n1\r\n$20\r\n18446744073709551615\r\n$20\r\n-9223372036854775808\r\n";
+
+   request req;
+   req.push("PING", -42, true, std::numeric_limits<std::uint64_t>::max(), std::numeric_limits<std::int64_t>::min());
+   BOOST_CHECK_EQUAL(req.payload(), std::pmr::string{res});
+}
+
+// Counts the allocations made through it.
+class counting_resource : public std::pmr::memory_resource {
+public:
+   int allocations = 0;
+
+private:
+   auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override
+   {
+      ++allocations;
+      return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+   }
+
+   void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+      { std::pmr::new_delete_resource()->deallocate(p, bytes, alignment); }
+
+   auto do_is_equal(std::pmr::memory_resource const& other) const noexcept -> bool override
+      { return this == &other; }
+};
+
+BOOST_AUTO_TEST_CASE(push_allocates_once)
+{
+   std::vector<std::string> in;
+   for (int i = 0; i < 1000; ++i)
+      in.push_back("element-" + std::to_string(i));
+
+   counting_resource resource;
+   request req{{}, &resource};
+   req.push_range("RPUSH", "key", in);
+   BOOST_CHECK_EQUAL(resource.allocations, 1);
+
+   auto const size = req.payload().size();
+   req.push("SET", "key", std::string(1000, 'a'), "EX", 10);
+   BOOST_CHECK_EQUAL(resource.allocations, 2);
+
+   BOOST_CHECK_EQUAL(req.payload().substr(size, 4), std::pmr::string{"*5\r\n"});
+   BOOST_CHECK_EQUAL(req.payload().size(), size + 4 + 9 + 9 + 1009 + 8 + 8);
+}
+
+BOOST_AUTO_TEST_CASE(command_catalogue)
+{
+   namespace cmd = aedis::cmd;
+
+   static_assert(cmd::set.header() == "*3\r\n$3\r\nSET\r\n");
+   static_assert(cmd::hset<5>.header() == "*12\r\n$4\r\nHSET\r\n");
+   static_assert(cmd::hset<5>.name() == "HSET");
+   static_assert(cmd::subscribe<1>.has_push_response());
+   static_assert(!cmd::get.has_push_response());
+   static_assert(cmd::hello.is_hello());
+
+   request req1;
+   req1.push(cmd::hello, 3);
+   req1.push(cmd::set, "key", 42);
+   req1.push(cmd::hset<2>, "key", std::make_pair("f1", "v1"), "f2", "v2");
+   req1.push(cmd::subscribe<2>, "channel1", "channel2");
+
+   request req2;
+   req2.push("HELLO", 3);
+   req2.push("SET", "key", 42);
+   req2.push("HSET", "key", "f1", "v1", "f2", "v2");
+   req2.push("SUBSCRIBE", "channel1", "channel2");
+
+   BOOST_CHECK_EQUAL(req1.payload(), req2.payload());
+   BOOST_CHECK_EQUAL(req1.size(), 3UL);
+   BOOST_TEST(req1.has_hello_priority() == false);
+
+   request req3;
+   req3.push(cmd::hello, 3);
+   BOOST_TEST(req3.has_hello_priority());
+}
+
+BOOST_AUTO_TEST_CASE(command_lookup)
+{
+   namespace cmd = aedis::cmd;
+
+   static_assert(cmd::lookup("SSUBSCRIBE")->has_push_response());
+   static_assert(cmd::lookup("PUNSUBSCRIBE")->has_push_response());
+   static_assert(cmd::lookup("BLPOP")->is_blocking());
+   static_assert(cmd::lookup("GET")->is_readonly());
+   static_assert(!cmd::lookup("GET")->is_multi_key());
+   static_assert(cmd::lookup("MSET")->key_step == 2);
+   static_assert(cmd::lookup("MSET")->is_multi_key());
+   static_assert(cmd::lookup("EVAL")->has_movable_keys());
+   static_assert(cmd::lookup("get") == cmd::lookup("GET"));
+   static_assert(cmd::lookup("GETX") == nullptr);
+   static_assert(cmd::lookup("") == nullptr);
+   static_assert(cmd::get.get_info() == cmd::lookup("GET"));
+
+   for (auto const& info : cmd::detail::commands)
+      BOOST_CHECK_EQUAL(cmd::lookup(info.name), &info);
+
+   request req;
+   req.push("SSUBSCRIBE", "channel");
+   req.push("punsubscribe");
+   req.push("GET", "key");
+   BOOST_CHECK_EQUAL(req.size(), 1UL);
+}
+
+BOOST_AUTO_TEST_CASE(push_range_split)
+{
+   std::vector<std::string> const in{"a", "b", "c", "d", "e"};
+
+   request req1;
+   req1.get_config().max_range_size = 2;
+   req1.push_range("SADD", "key", in);
+   req1.push_range("RPUSH", in);
+   req1.push("PING");
+
+   request req2;
+   req2.push("SADD", "key", "a", "b");
+   req2.push("SADD", "key", "c", "d");
+   req2.push("SADD", "key", "e");
+   req2.push("RPUSH", "a", "b");
+   req2.push("RPUSH", "c", "d");
+   req2.push("RPUSH", "e");
+   req2.push("PING");
+
+   BOOST_CHECK_EQUAL(req1.payload(), req2.payload());
+   BOOST_CHECK_EQUAL(req1.size(), 7UL);
+   BOOST_CHECK_EQUAL(req1.responses(), 3UL);
+
+   std::vector<std::size_t> merged;
+   for (auto const& e : req1.merged())
+      merged.push_back(e.index);
+
+   std::vector<std::size_t> const expected{1, 2, 4, 5};
+   BOOST_CHECK_EQUAL_COLLECTIONS(merged.begin(), merged.end(), expected.begin(), expected.end());
+   BOOST_TEST((req1.merged().front().numbers == aedis::resp3::detail::merge::sum));
+   BOOST_TEST((req1.merged().back().numbers == aedis::resp3::detail::merge::max));
+
+   // Each element takes 7 bytes serialized, $1\r\na\r\n, so parts
+   // of at most 20 bytes hold two of the five elements.
+   request req3;
+   req3.get_config().max_range_bytes = 20;
+   req3.push_range("DEL", in);
+   BOOST_CHECK_EQUAL(req3.size(), 3UL);
+   BOOST_CHECK_EQUAL(req3.responses(), 1UL);
+
+   req3.clear();
+   BOOST_TEST(req3.merged().empty());
+
+   // Commands whose result would change are not split.
+   request req4;
+   req4.get_config().max_range_size = 2;
+   req4.push_range("SINTER", in);
+   req4.push_range("MSETNX", std::vector<std::pair<std::string, std::string>>{{"a", "1"}, {"b", "2"}, {"c", "3"}});
+
+   request req5;
+   req5.push("SINTER", "a", "b", "c", "d", "e");
+   req5.push("MSETNX", "a", "1", "b", "2", "c", "3");
+
+   BOOST_CHECK_EQUAL(req4.payload(), req5.payload());
+   BOOST_CHECK_EQUAL(req4.size(), 2UL);
+   BOOST_TEST(req4.merged().empty());
+}
+
+template <class T1, class T2, class T3>
+auto set_incrby(T1 const& key, T2 const& value, T3 const& incr)
+{
+   request req;
+   req.push("SET", key, value);
+   req.push("INCRBY", "counter", incr);
+   return req.payload();
+}
+
+BOOST_AUTO_TEST_CASE(prepared_request_bind)
+{
+   aedis::resp3::prepared_request req;
+   req.push("SET", "key", "");
+   req.push(aedis::cmd::incrby, "counter", 1);
+   BOOST_CHECK_EQUAL(req.slots(), 4UL);
+   BOOST_CHECK_EQUAL(req.get().size(), 2UL);
+
+   // Different length.
+   req.bind(1, "value");
+   BOOST_CHECK_EQUAL(req.get().payload(), set_incrby("key", "value", 1));
+
+   // Same length.
+   req.bind(1, "other");
+   BOOST_CHECK_EQUAL(req.get().payload(), set_incrby("key", "other", 1));
+
+   // Integers and a slot before others.
+   req.bind(0, std::string(20, 'k'));
+   req.bind(3, -100);
+   BOOST_CHECK_EQUAL(req.get().payload(), set_incrby(std::string(20, 'k'), "other", -100));
+
+   request const& r = req;
+   BOOST_CHECK_EQUAL(&r, &req.get());
+   BOOST_CHECK_THROW(req.bind(4, "x"), std::out_of_range);
+}
+
+// A stream that appends what is written to a string.
+struct string_sink {
+   std::string data;
+
+   template <class ConstBufferSequence>
+   auto write_some(ConstBufferSequence const& buffers, boost::system::error_code&) -> std::size_t
+   {
+      auto const n = boost::asio::buffer_size(buffers);
+      auto const size = data.size();
+      data.resize(size + n);
+      return boost::asio::buffer_copy(boost::asio::buffer(&data[size], n), buffers);
+   }
+
+   template <class ConstBufferSequence>
+   auto write_some(ConstBufferSequence const& buffers) -> std::size_t
+   {
+      boost::system::error_code ec;
+      return write_some(buffers, ec);
+   }
+};
+
+BOOST_AUTO_TEST_CASE(borrowed_arguments)
+{
+   using aedis::resp3::borrow;
+
+   std::string const value(100000, 'v');
+   std::vector<aedis::resp3::borrowed_bulk> list{borrow("a"), borrow(value)};
+
+   request req1;
+   req1.push("SET", "key", borrow(value));
+   req1.push_range("RPUSH", borrow("list"), list);
+
+   request req2;
+   req2.push("SET", "key", value);
+   req2.push("RPUSH", "list", "a", value);
+
+   // Only the framing is stored.
+   BOOST_CHECK_EQUAL(req1.segments().size(), 4UL);
+   BOOST_TEST(req1.payload().size() < 100);
+   BOOST_CHECK_EQUAL(req1.size(), 2UL);
+
+   string_sink sink;
+   aedis::resp3::write(sink, req1);
+   BOOST_CHECK_EQUAL(sink.data, std::string(req2.payload()));
+
+   req1.clear();
+   BOOST_TEST(req1.segments().empty());
+}
+
+#if !defined(_WIN32)
+BOOST_AUTO_TEST_CASE(file_arguments)
+{
+   std::string const content = "header" + std::string(200000, 'f') + "trailer";
+
+   auto* file = std::tmpfile();
+   BOOST_TEST_REQUIRE(file != nullptr);
+   BOOST_CHECK_EQUAL(std::fwrite(content.data(), 1, content.size(), file), content.size());
+   std::fflush(file);
+
+   auto const body = content.substr(6, 200000);
+   aedis::resp3::file_arg const arg{fileno(file), 6, body.size()};
+
+   request req1;
+   req1.push("SET", "key", arg);
+   req1.push("RPUSH", "list", aedis::resp3::borrow("a"), arg, "b");
+
+   request req2;
+   req2.push("SET", "key", body);
+   req2.push("RPUSH", "list", "a", body, "b");
+
+   BOOST_TEST(req1.payload().size() < 100);
+
+   string_sink sink;
+   boost::system::error_code ec;
+   aedis::resp3::write(sink, req1, ec);
+   BOOST_TEST(!ec);
+   BOOST_CHECK_EQUAL(sink.data, std::string(req2.payload()));
+
+   // A file shorter than the argument.
+   request req3;
+   req3.push("SET", "key", aedis::resp3::file_arg{fileno(file), 0, content.size() + 1});
+   aedis::resp3::write(sink, req3, ec);
+   BOOST_CHECK_EQUAL(ec, boost::asio::error::eof);
+
+   std::fclose(file);
+}
+#endif